@@ -0,0 +1,47 @@
+/* Per-call-site method cache for $obj->$name(), installed into Zend/ by
+ * base/tune-engine.sh call-site-cache.
+ *
+ * ZEND_INIT_METHOD_CALL caches the method of a literal name per class entry
+ * in the run-time cache slot of the literal. A variable name has no literal,
+ * so the compiler gives such a call ZEND_CALL_SITE_CACHE_SLOTS slots of its
+ * own, starting at opline->extended_value, and the handler looks the method
+ * up through zend_call_site_get_method(). The slots hold the most recently
+ * used (class entry, name, method) triples. A name is only cached if it is
+ * interned, so an equal pointer is an equal name for the rest of the
+ * request. Like the literal cache, __call() trampolines are never cached.
+ */
+#ifndef ZEND_CALL_SITE_CACHE_H
+#define ZEND_CALL_SITE_CACHE_H
+
+#include "zend_string.h"
+
+#define ZEND_CALL_SITE_CACHE_ENTRIES 4
+#define ZEND_CALL_SITE_CACHE_SLOTS (3 * ZEND_CALL_SITE_CACHE_ENTRIES)
+
+static zend_always_inline zend_function *zend_call_site_get_method(zval **object_ptr, char *name, int len, void **slots TSRMLS_DC)
+{
+	zval *object = *object_ptr;
+	zend_class_entry *ce = Z_OBJCE_P(object);
+	zend_function *fbc;
+	int i;
+
+	for (i = 0; i < ZEND_CALL_SITE_CACHE_SLOTS; i += 3) {
+		if (slots[i] == ce && slots[i + 1] == name) {
+			return slots[i + 2];
+		}
+	}
+
+	fbc = Z_OBJ_HT_P(object)->get_method(object_ptr, name, len, NULL TSRMLS_CC);
+	if (fbc != NULL &&
+	    IS_INTERNED(name) &&
+	    (fbc->common.fn_flags & ZEND_ACC_CALL_VIA_HANDLER) == 0 &&
+	    *object_ptr == object) {
+		memmove(slots + 3, slots, (ZEND_CALL_SITE_CACHE_SLOTS - 3) * sizeof(void *));
+		slots[0] = ce;
+		slots[1] = name;
+		slots[2] = fbc;
+	}
+	return fbc;
+}
+
+#endif /* ZEND_CALL_SITE_CACHE_H */
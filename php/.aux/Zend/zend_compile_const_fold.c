@@ -0,0 +1,123 @@
+/* Compile-time constant folding for zend_do_binary_op() and
+ * zend_do_unary_op() in Zend/zend_compile.c, spliced in by
+ * base/tune-engine.sh const-fold after the original functions, which it
+ * renames to zend_emit_binary_op() and zend_emit_unary_op().
+ *
+ * When every operand is a scalar literal and the operator cannot raise a
+ * notice or an error at run time, the operator is evaluated here and the
+ * result becomes an IS_CONST znode, so no opcode, temporary or literal is
+ * emitted for it. Folded expressions nest: "a" . "b" . "c" leaves a single
+ * literal behind.
+ *
+ * A folded result must not depend on any INI setting, since it is fixed
+ * before ini_set() can run. Hence no concatenation with a double, whose
+ * string form follows the precision setting.
+ */
+static int zend_fold_operand(const znode *op) /* {{{ */
+{
+	if (op->op_type != IS_CONST) {
+		return 0;
+	}
+	switch (Z_TYPE(op->u.constant)) {
+		case IS_NULL:
+		case IS_LONG:
+		case IS_DOUBLE:
+		case IS_BOOL:
+		case IS_STRING:
+			return 1;
+	}
+	return 0;
+}
+/* }}} */
+
+static int zend_fold_binary_op(zend_uchar op, znode *result, const znode *op1, const znode *op2 TSRMLS_DC) /* {{{ */
+{
+	zval folded;
+
+	switch (op) {
+		case ZEND_ADD:
+		case ZEND_SUB:
+		case ZEND_MUL:
+		case ZEND_CONCAT:
+		case ZEND_BW_OR:
+		case ZEND_BW_AND:
+		case ZEND_BW_XOR:
+		case ZEND_BOOL_XOR:
+		case ZEND_IS_IDENTICAL:
+		case ZEND_IS_NOT_IDENTICAL:
+		case ZEND_IS_EQUAL:
+		case ZEND_IS_NOT_EQUAL:
+		case ZEND_IS_SMALLER:
+		case ZEND_IS_SMALLER_OR_EQUAL:
+			break;
+		default:
+			/* ZEND_DIV and ZEND_MOD warn about a zero divisor, ZEND_SL and
+			 * ZEND_SR depend on the width of long on the executing host. */
+			return 0;
+	}
+	if (!zend_fold_operand(op1) || !zend_fold_operand(op2)) {
+		return 0;
+	}
+	if (op == ZEND_CONCAT
+		&& (Z_TYPE(op1->u.constant) == IS_DOUBLE || Z_TYPE(op2->u.constant) == IS_DOUBLE)) {
+		return 0;
+	}
+	INIT_ZVAL(folded);
+	if (get_binary_op(op)(&folded, (zval *) &op1->u.constant, (zval *) &op2->u.constant TSRMLS_CC) != SUCCESS) {
+		zval_dtor(&folded);
+		return 0;
+	}
+	zval_dtor((zval *) &op1->u.constant);
+	zval_dtor((zval *) &op2->u.constant);
+	result->op_type = IS_CONST;
+	result->u.constant = folded;
+	return 1;
+}
+/* }}} */
+
+static int zend_fold_unary_op(zend_uchar op, znode *result, const znode *op1 TSRMLS_DC) /* {{{ */
+{
+	zval folded;
+
+	if (!zend_fold_operand(op1)) {
+		return 0;
+	}
+	switch (op) {
+		case ZEND_BOOL_NOT:
+			break;
+		case ZEND_BW_NOT:
+			/* ~null and ~true are fatal errors at run time. */
+			if (Z_TYPE(op1->u.constant) == IS_NULL || Z_TYPE(op1->u.constant) == IS_BOOL) {
+				return 0;
+			}
+			break;
+		default:
+			return 0;
+	}
+	INIT_ZVAL(folded);
+	if (get_unary_op(op)(&folded, (zval *) &op1->u.constant TSRMLS_CC) != SUCCESS) {
+		zval_dtor(&folded);
+		return 0;
+	}
+	zval_dtor((zval *) &op1->u.constant);
+	result->op_type = IS_CONST;
+	result->u.constant = folded;
+	return 1;
+}
+/* }}} */
+
+void zend_do_binary_op(zend_uchar op, znode *result, const znode *op1, const znode *op2 TSRMLS_DC) /* {{{ */
+{
+	if (!zend_fold_binary_op(op, result, op1, op2 TSRMLS_CC)) {
+		zend_emit_binary_op(op, result, op1, op2 TSRMLS_CC);
+	}
+}
+/* }}} */
+
+void zend_do_unary_op(zend_uchar op, znode *result, const znode *op1 TSRMLS_DC) /* {{{ */
+{
+	if (!zend_fold_unary_op(op, result, op1 TSRMLS_CC)) {
+		zend_emit_unary_op(op, result, op1 TSRMLS_CC);
+	}
+}
+/* }}} */
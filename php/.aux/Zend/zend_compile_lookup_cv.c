@@ -0,0 +1,84 @@
+/* Replacement for lookup_cv() in Zend/zend_compile.c, spliced in by
+ * base/tune-engine.sh cv-index.
+ *
+ * Once an op_array has more than ZEND_CV_INDEX_MIN compiled variables, their
+ * names are kept in a hash index (name -> slot), so that a lookup no longer
+ * scans op_array->vars linearly; the vars array also grows geometrically
+ * instead of by 16 entries at a time. The index belongs to the op_array that
+ * was looked up last and is rebuilt when compilation switches to another one
+ * (nested functions, closures); it is reset on the first variable of every
+ * op_array, so a new op_array allocated at the address of an old one never
+ * sees stale entries.
+ */
+#define ZEND_CV_INDEX_MIN 32
+
+#ifndef ZTS
+static HashTable cv_index;
+static int cv_index_initialized = 0;
+static zend_op_array *cv_index_op_array = NULL;
+static int cv_index_count = 0;
+
+static void cv_index_sync(zend_op_array *op_array) /* {{{ */
+{
+	if (!cv_index_initialized) {
+		zend_hash_init(&cv_index, 64, NULL, NULL, 1);
+		cv_index_initialized = 1;
+	}
+	if (cv_index_op_array != op_array || cv_index_count > op_array->last_var) {
+		zend_hash_clean(&cv_index);
+		cv_index_op_array = op_array;
+		cv_index_count = 0;
+	}
+	for (; cv_index_count < op_array->last_var; cv_index_count++) {
+		zend_compiled_variable *cv = &op_array->vars[cv_index_count];
+
+		zend_hash_quick_add(&cv_index, cv->name, cv->name_len + 1, cv->hash_value,
+			&cv_index_count, sizeof(int), NULL);
+	}
+}
+/* }}} */
+#endif
+
+static int lookup_cv(zend_op_array *op_array, char* name, int name_len, ulong hash TSRMLS_DC) /* {{{ */
+{
+	int i = 0;
+	ulong hash_value = hash ? hash : zend_inline_hash_func(name, name_len+1);
+
+#ifndef ZTS
+	if (op_array->last_var == 0 && cv_index_op_array == op_array) {
+		cv_index_op_array = NULL;
+	}
+	if (op_array->last_var >= ZEND_CV_INDEX_MIN) {
+		int *slot;
+
+		cv_index_sync(op_array);
+		if (zend_hash_quick_find(&cv_index, name, name_len + 1, hash_value, (void **) &slot) == SUCCESS) {
+			str_efree(name);
+			return *slot;
+		}
+		i = op_array->last_var;
+	}
+#endif
+
+	while (i < op_array->last_var) {
+		if (op_array->vars[i].name == name ||
+		    (op_array->vars[i].hash_value == hash_value &&
+		     op_array->vars[i].name_len == name_len &&
+		     memcmp(op_array->vars[i].name, name, name_len) == 0)) {
+			str_efree(name);
+			return i;
+		}
+		i++;
+	}
+	i = op_array->last_var;
+	op_array->last_var++;
+	if (op_array->last_var > CG(context).vars_size) {
+		CG(context).vars_size = CG(context).vars_size ? CG(context).vars_size * 2 : 16;
+		op_array->vars = erealloc(op_array->vars, CG(context).vars_size*sizeof(zend_compiled_variable));
+	}
+	op_array->vars[i].name = zend_new_interned_string(name, name_len + 1, 1 TSRMLS_CC);
+	op_array->vars[i].name_len = name_len;
+	op_array->vars[i].hash_value = hash_value;
+	return i;
+}
+/* }}} */
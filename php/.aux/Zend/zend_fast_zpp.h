@@ -0,0 +1,48 @@
+/* Fast argument parsing for internal functions, installed into Zend/ by
+ * base/tune-engine.sh fast-zpp.
+ *
+ * zend_parse_parameters() interprets its type spec one character at a time
+ * and collects its destinations through a va_list, even when every argument
+ * already has the requested type. The macros below read the arguments from
+ * the VM stack directly and succeed only on an exact type match, so a call
+ * site can try them first and fall back to zend_parse_parameters() with the
+ * same spec for conversions, optional arguments and error reporting:
+ *
+ *	if (!(ZEND_NUM_ARGS() == 2 && ZEND_FAST_ARG_S(0, s1, s1_len) && ZEND_FAST_ARG_L(1, n))
+ *		&& zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "sl", &s1, &s1_len, &n) == FAILURE) {
+ *		return;
+ *	}
+ *
+ * They take the same destinations as the matching spec characters l, s, b, z
+ * and a, without the &. Only use them inside an internal function, where
+ * the top of the VM stack holds the argument count.
+ */
+#ifndef ZEND_FAST_ZPP_H
+#define ZEND_FAST_ZPP_H
+
+#include "zend_execute.h"
+
+/* The n-th (0-based) argument of the running internal function. */
+#define ZEND_FAST_ARG(n) \
+	(*((zval **) zend_vm_stack_top(TSRMLS_C) - 1 - ZEND_NUM_ARGS() + (n)))
+
+#define ZEND_FAST_ARG_L(n, dest) \
+	(EXPECTED(Z_TYPE_P(ZEND_FAST_ARG(n)) == IS_LONG) \
+		? ((dest) = Z_LVAL_P(ZEND_FAST_ARG(n)), 1) : 0)
+
+#define ZEND_FAST_ARG_S(n, dest, dest_len) \
+	(EXPECTED(Z_TYPE_P(ZEND_FAST_ARG(n)) == IS_STRING) \
+		? ((dest) = Z_STRVAL_P(ZEND_FAST_ARG(n)), (dest_len) = Z_STRLEN_P(ZEND_FAST_ARG(n)), 1) : 0)
+
+#define ZEND_FAST_ARG_B(n, dest) \
+	(EXPECTED(Z_TYPE_P(ZEND_FAST_ARG(n)) == IS_BOOL) \
+		? ((dest) = (zend_bool) Z_LVAL_P(ZEND_FAST_ARG(n)), 1) : 0)
+
+#define ZEND_FAST_ARG_Z(n, dest) \
+	((dest) = ZEND_FAST_ARG(n), 1)
+
+#define ZEND_FAST_ARG_A(n, dest) \
+	(EXPECTED(Z_TYPE_P(ZEND_FAST_ARG(n)) == IS_ARRAY) \
+		? ((dest) = ZEND_FAST_ARG(n), 1) : 0)
+
+#endif /* ZEND_FAST_ZPP_H */
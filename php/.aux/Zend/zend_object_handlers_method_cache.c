@@ -0,0 +1,52 @@
+/* Lookup key cache for dynamic method names, spliced into
+ * Zend/zend_object_handlers.c by base/tune-engine.sh method-cache.
+ *
+ * Calls like $obj->$name() and $class::$name() reach zend_std_get_method()
+ * and zend_std_get_static_method() without a literal key, so the method name
+ * has to be lowercased and hashed on every call. The names used this way are
+ * nearly always interned, so the lowercased name and its hash are cached in
+ * a small direct-mapped table indexed by the address of the name. An entry is
+ * only used if it also holds the same name, which keeps it correct when an
+ * interned string is released at the end of a request and its address is
+ * reused. Class, visibility and __call() handling are left to the caller.
+ */
+#include "zend_string.h"
+
+#define ZEND_METHOD_KEY_CACHE_SIZE 64
+#define ZEND_METHOD_KEY_MAX_LEN 48
+
+#ifndef ZTS
+typedef struct _zend_method_key {
+	const char *name;
+	int len;
+	ulong hash_value;
+	char raw[ZEND_METHOD_KEY_MAX_LEN];
+	char lc[ZEND_METHOD_KEY_MAX_LEN];
+} zend_method_key;
+
+static zend_method_key method_keys[ZEND_METHOD_KEY_CACHE_SIZE];
+#endif
+
+/* Writes the lowercased name to lc_name (len + 1 bytes) and returns its hash. */
+static ulong zend_dynamic_method_key(char *lc_name, const char *name, int len) /* {{{ */
+{
+#ifndef ZTS
+	if (IS_INTERNED(name) && len < ZEND_METHOD_KEY_MAX_LEN) {
+		zend_method_key *key = &method_keys[((zend_uintptr_t) name >> 3) & (ZEND_METHOD_KEY_CACHE_SIZE - 1)];
+
+		if (key->name != name || key->len != len || memcmp(key->raw, name, len) != 0) {
+			zend_str_tolower_copy(key->lc, name, len);
+			key->hash_value = zend_hash_func(key->lc, len + 1);
+			memcpy(key->raw, name, len);
+			key->len = len;
+			key->name = name;
+		}
+		memcpy(lc_name, key->lc, len + 1);
+		return key->hash_value;
+	}
+#endif
+	zend_str_tolower_copy(lc_name, name, len);
+	return zend_hash_func(lc_name, len + 1);
+}
+/* }}} */
+
@@ -0,0 +1,151 @@
+/* Removal of unreachable opcodes, spliced into Zend/zend_opcode.c by
+ * base/tune-engine.sh dead-code and called at the start of pass_two(), while
+ * jump targets are still opline numbers.
+ *
+ * Reachability is followed from the first opcode, the catch blocks and the
+ * break/continue targets. Only JMP, RETURN, RETURN_BY_REF, THROW and EXIT
+ * end a path, everything else is assumed to fall through, so an opcode is
+ * only dropped if nothing can get to it, e.g. code after a return or a
+ * throw, or an else branch folded away by const-fold. The opline numbers in
+ * jumps, brk_cont_array and try_catch_array are then renumbered. op_arrays
+ * with a goto, delayed early binding or interactive mode are left alone, as
+ * they refer to opline numbers in ways this pass does not track.
+ */
+/* Opline numbers past the end (unset brk_cont fields are -1) are kept. */
+#define ZEND_DEAD_CODE_MAP(num) ((num) <= op_array->last ? map[num] : (num))
+
+static void zend_dead_code_edge(zend_uint target, zend_uint last, zend_uchar *reachable, zend_uint *stack, zend_uint *top) /* {{{ */
+{
+	if (target < last && !reachable[target]) {
+		reachable[target] = 1;
+		stack[(*top)++] = target;
+	}
+}
+/* }}} */
+
+static void zend_remove_unreachable_ops(zend_op_array *op_array) /* {{{ */
+{
+	zend_uint i, n, top = 0, kept = 0;
+	zend_uchar *reachable;
+	zend_uint *stack, *map;
+	zend_op *opline;
+
+	if ((op_array->fn_flags & ZEND_ACC_INTERACTIVE) || op_array->early_binding != (zend_uint) -1 || op_array->last == 0) {
+		return;
+	}
+	for (i = 0; i < op_array->last; i++) {
+		if (op_array->opcodes[i].opcode == ZEND_GOTO) {
+			return;
+		}
+	}
+
+	reachable = ecalloc(op_array->last, sizeof(zend_uchar));
+	stack = safe_emalloc(op_array->last, sizeof(zend_uint), 0);
+
+	zend_dead_code_edge(0, op_array->last, reachable, stack, &top);
+	/* The executor may rely on the final opcode (ZEND_HANDLE_EXCEPTION). */
+	zend_dead_code_edge(op_array->last - 1, op_array->last, reachable, stack, &top);
+	for (i = 0; i < (zend_uint) op_array->last_try_catch; i++) {
+		zend_dead_code_edge(op_array->try_catch_array[i].catch_op, op_array->last, reachable, stack, &top);
+	}
+	for (i = 0; i < (zend_uint) op_array->last_brk_cont; i++) {
+		zend_dead_code_edge(op_array->brk_cont_array[i].brk, op_array->last, reachable, stack, &top);
+		zend_dead_code_edge(op_array->brk_cont_array[i].cont, op_array->last, reachable, stack, &top);
+	}
+
+	while (top > 0) {
+		n = stack[--top];
+		opline = &op_array->opcodes[n];
+		switch (opline->opcode) {
+			case ZEND_JMP:
+				zend_dead_code_edge(opline->op1.opline_num, op_array->last, reachable, stack, &top);
+				continue;
+			case ZEND_RETURN:
+			case ZEND_RETURN_BY_REF:
+			case ZEND_THROW:
+			case ZEND_EXIT:
+				continue;
+			case ZEND_JMPZNZ:
+				zend_dead_code_edge(opline->extended_value, op_array->last, reachable, stack, &top);
+				/* break omitted intentionally */
+			case ZEND_JMPZ:
+			case ZEND_JMPNZ:
+			case ZEND_JMPZ_EX:
+			case ZEND_JMPNZ_EX:
+			case ZEND_JMP_SET:
+#ifdef ZEND_JMP_SET_VAR
+			case ZEND_JMP_SET_VAR:
+#endif
+			case ZEND_FE_RESET:
+			case ZEND_FE_FETCH:
+			case ZEND_NEW:
+				zend_dead_code_edge(opline->op2.opline_num, op_array->last, reachable, stack, &top);
+				break;
+			case ZEND_CATCH:
+				zend_dead_code_edge(opline->extended_value, op_array->last, reachable, stack, &top);
+				break;
+		}
+		zend_dead_code_edge(n + 1, op_array->last, reachable, stack, &top);
+	}
+
+	/* map[i] is the new number of opcode i, or of the next kept one. The
+	 * literals of dropped opcodes stay in the table until the op_array is
+	 * destroyed, as other opcodes may share them. */
+	map = safe_emalloc(op_array->last + 1, sizeof(zend_uint), 0);
+	for (i = 0; i < op_array->last; i++) {
+		map[i] = kept;
+		if (reachable[i]) {
+			if (kept != i) {
+				op_array->opcodes[kept] = op_array->opcodes[i];
+			}
+			kept++;
+		}
+	}
+	map[op_array->last] = kept;
+
+	if (kept != op_array->last) {
+		for (i = 0; i < kept; i++) {
+			opline = &op_array->opcodes[i];
+			switch (opline->opcode) {
+				case ZEND_JMP:
+					opline->op1.opline_num = ZEND_DEAD_CODE_MAP(opline->op1.opline_num);
+					break;
+				case ZEND_JMPZNZ:
+					opline->extended_value = ZEND_DEAD_CODE_MAP(opline->extended_value);
+					/* break omitted intentionally */
+				case ZEND_JMPZ:
+				case ZEND_JMPNZ:
+				case ZEND_JMPZ_EX:
+				case ZEND_JMPNZ_EX:
+				case ZEND_JMP_SET:
+#ifdef ZEND_JMP_SET_VAR
+				case ZEND_JMP_SET_VAR:
+#endif
+				case ZEND_FE_RESET:
+				case ZEND_FE_FETCH:
+				case ZEND_NEW:
+					opline->op2.opline_num = ZEND_DEAD_CODE_MAP(opline->op2.opline_num);
+					break;
+				case ZEND_CATCH:
+					opline->extended_value = ZEND_DEAD_CODE_MAP(opline->extended_value);
+					break;
+			}
+		}
+		for (i = 0; i < (zend_uint) op_array->last_try_catch; i++) {
+			op_array->try_catch_array[i].try_op = ZEND_DEAD_CODE_MAP(op_array->try_catch_array[i].try_op);
+			op_array->try_catch_array[i].catch_op = ZEND_DEAD_CODE_MAP(op_array->try_catch_array[i].catch_op);
+		}
+		for (i = 0; i < (zend_uint) op_array->last_brk_cont; i++) {
+			op_array->brk_cont_array[i].start = ZEND_DEAD_CODE_MAP(op_array->brk_cont_array[i].start);
+			op_array->brk_cont_array[i].cont = ZEND_DEAD_CODE_MAP(op_array->brk_cont_array[i].cont);
+			op_array->brk_cont_array[i].brk = ZEND_DEAD_CODE_MAP(op_array->brk_cont_array[i].brk);
+		}
+		op_array->last = kept;
+	}
+
+	efree(map);
+	efree(stack);
+	efree(reachable);
+}
+/* }}} */
+
@@ -0,0 +1,22 @@
+<?php
+/* Internal function call benchmark: argument parsing overhead.
+ *
+ * Makes $argv[1] (default 5000000) rounds of cheap builtin calls whose cost
+ * is mostly in the call and in zend_parse_parameters(): strlen(), strcmp(),
+ * strncmp() and str_replace(). Compare two builds with bench.sh, e.g. before
+ * and after tune-engine.sh fast-zpp.
+ */
+$n = isset($argv[1]) ? (int)$argv[1] : 5000000;
+$a = "content-type";
+$b = "content-length";
+
+$start = microtime(true);
+$sum = 0;
+for ($i = 0; $i < $n; $i++) {
+	$sum += strlen($a);
+	$sum += strcmp($a, $b);
+	$sum += strncmp($a, $b, 8);
+	$sum += strlen(str_replace("-", "_", $a));
+}
+$elapsed = microtime(true) - $start;
+printf("builtin_calls: %d iterations: %.3f s\n", $n, $elapsed);
@@ -0,0 +1,32 @@
+<?php
+/* Compile-time benchmark for functions with many compiled variables.
+ *
+ * Generates a function with $argv[1] (default 20000) distinct locals, each
+ * of them referenced several times, and reports how long it takes to compile
+ * it. Nothing of the generated function is executed.
+ */
+$count = isset($argv[1]) ? (int)$argv[1] : 20000;
+$rounds = isset($argv[2]) ? (int)$argv[2] : 3;
+
+$code = "<?php\nfunction generated_cvs() {\n";
+for ($i = 0; $i < $count; $i++) {
+	$code .= "\t\$v$i = $i;\n";
+}
+for ($i = 0; $i < $count; $i++) {
+	$code .= "\t\$v$i += \$v" . (($i * 7919) % $count) . " + \$v$i;\n";
+}
+$code .= "}\n";
+
+$best = null;
+for ($r = 0; $r < $rounds; $r++) {
+	$file = tempnam(sys_get_temp_dir(), "cvs");
+	file_put_contents($file, str_replace("generated_cvs", "generated_cvs_$r", $code));
+	$start = microtime(true);
+	include $file;
+	$elapsed = microtime(true) - $start;
+	unlink($file);
+	if ($best === null || $elapsed < $best) {
+		$best = $elapsed;
+	}
+}
+printf("compile_cvs: %d variables, best of %d: %.3f s\n", $count, $rounds, $best);
@@ -0,0 +1,19 @@
+<?php
+/* Run-time benchmark for expressions built from literals only.
+ *
+ * Evaluates arithmetic, string concatenation and comparisons of literals
+ * $argv[1] (default 5000000) times; with constant folding, the loop body is
+ * reduced to assignments of precomputed literals.
+ */
+$n = isset($argv[1]) ? (int)$argv[1] : 5000000;
+
+$start = microtime(true);
+for ($i = 0; $i < $n; $i++) {
+	$a = 60 * 60 * 24 * 7 + 1;
+	$b = "SELECT * FROM " . "users" . " WHERE " . "id" . " = ?";
+	$c = 1 << 4 | 1 << 2 | 1;
+	$d = "1.5" + 2.5 * 4 - 1;
+	$e = !(3 == "3") xor 0x10 === 16;
+}
+$elapsed = microtime(true) - $start;
+printf("const_exprs: %d iterations: %.3f s\n", $n, $elapsed);
@@ -0,0 +1,41 @@
+<?php
+/* Method lookup benchmark: calls through a variable method name.
+ *
+ * Makes $argv[1] (default 5000000) rounds of $obj->$name() and
+ * $class::$name() calls, cycling through a few mixed-case method names as
+ * frameworks do when dispatching to actions and hooks.
+ */
+class DynamicCalls {
+	private $hits = 0;
+
+	function indexAction() {
+		return ++$this->hits;
+	}
+
+	function showAction() {
+		return ++$this->hits;
+	}
+
+	function beforeSave() {
+		return ++$this->hits;
+	}
+
+	static function create() {
+		return 1;
+	}
+}
+
+$n = isset($argv[1]) ? (int)$argv[1] : 5000000;
+$names = array("indexAction", "showAction", "beforeSave", "IndexAction");
+$class = "DynamicCalls";
+$static = "create";
+
+$start = microtime(true);
+$obj = new DynamicCalls();
+for ($i = 0; $i < $n; $i++) {
+	$name = $names[$i & 3];
+	$obj->$name();
+	$class::$static();
+}
+$elapsed = microtime(true) - $start;
+printf("dynamic_calls: %d iterations: %.3f s\n", $n, $elapsed);
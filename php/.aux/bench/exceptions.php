@@ -0,0 +1,39 @@
+<?php
+/* Exception benchmark: throw/catch used for control flow.
+ *
+ * Throws and catches $argv[1] (default 1000000) exceptions from a call
+ * stack $argv[2] (default 10) frames deep, as validation layers do, and
+ * reports the throw/catch rate. Every fifth exception has its trace
+ * string built, to also cover the cost of formatting the trace.
+ */
+class ValidationFailed extends Exception {
+}
+
+function validate($depth, $value) {
+	if ($depth > 0) {
+		return validate($depth - 1, $value);
+	}
+	if ($value % 2) {
+		throw new ValidationFailed("odd value", $value);
+	}
+	return $value;
+}
+
+$n = isset($argv[1]) ? (int)$argv[1] : 1000000;
+$depth = isset($argv[2]) ? (int)$argv[2] : 10;
+
+$start = microtime(true);
+$caught = 0;
+$traced = 0;
+for ($i = 0; $caught < $n; $i++) {
+	try {
+		validate($depth, $i);
+	} catch (ValidationFailed $e) {
+		if ($caught % 5 == 0) {
+			$traced += strlen($e->getTraceAsString());
+		}
+		$caught++;
+	}
+}
+$elapsed = microtime(true) - $start;
+printf("exceptions: %d thrown at depth %d: %.3f s, %.0f/s\n", $n, $depth, $elapsed, $n / $elapsed);
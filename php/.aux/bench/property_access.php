@@ -0,0 +1,37 @@
+<?php
+/* Property access benchmark: declared and dynamic properties.
+ *
+ * Makes $argv[1] (default 5000000) rounds of reads and writes of declared
+ * properties, on an object that was never iterated and on one whose
+ * properties table has been built by foreach, and of a dynamic property.
+ */
+class PropertyAccess {
+	public $id = 0;
+	public $name = "row";
+	protected $dirty = false;
+
+	function touch() {
+		$this->dirty = !$this->dirty;
+		return $this->id;
+	}
+}
+
+$n = isset($argv[1]) ? (int)$argv[1] : 5000000;
+
+$plain = new PropertyAccess();
+$iterated = new PropertyAccess();
+foreach ($iterated as $key => $value) {
+}
+$dynamic = new PropertyAccess();
+$dynamic->extra = 0;
+
+$start = microtime(true);
+for ($i = 0; $i < $n; $i++) {
+	$plain->id = $i;
+	$plain->touch();
+	$iterated->id = $plain->id;
+	$iterated->touch();
+	$dynamic->extra += $iterated->id & 1;
+}
+$elapsed = microtime(true) - $start;
+printf("property_access: %d iterations: %.3f s\n", $n, $elapsed);
@@ -0,0 +1,29 @@
+<?php
+/* Interpreter dispatch benchmark: array reads, writes and iteration.
+ *
+ * Fills a packed and a string-keyed array of $argv[1] (default 1000000)
+ * elements, then reads them back by index, by key and with foreach, over
+ * $argv[2] (default 5) rounds.
+ */
+$n = isset($argv[1]) ? (int)$argv[1] : 1000000;
+$rounds = isset($argv[2]) ? (int)$argv[2] : 5;
+
+$start = microtime(true);
+for ($r = 0; $r < $rounds; $r++) {
+	$list = array();
+	$map = array();
+	for ($i = 0; $i < $n; $i++) {
+		$list[] = $i;
+		$map["k$i"] = $i;
+	}
+	$sum = 0;
+	for ($i = 0; $i < $n; $i++) {
+		$sum += $list[$i] + $map["k$i"];
+	}
+	foreach ($map as $key => $value) {
+		$sum -= $value;
+	}
+	unset($list, $map);
+}
+$elapsed = microtime(true) - $start;
+printf("vm_arrays: %d elements, %d rounds: %.3f s\n", $n, $rounds, $elapsed);
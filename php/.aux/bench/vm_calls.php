@@ -0,0 +1,35 @@
+<?php
+/* Interpreter dispatch benchmark: user function and method calls.
+ *
+ * Makes $argv[1] (default 5000000) calls each to a function, a static
+ * method and an instance method, exercising the call and return opcodes.
+ */
+function vm_calls_add($a, $b) {
+	return $a + $b;
+}
+
+class VmCalls {
+	private $total = 0;
+
+	static function twice($a) {
+		return $a * 2;
+	}
+
+	function add($a) {
+		$this->total += $a;
+		return $this->total;
+	}
+}
+
+$n = isset($argv[1]) ? (int)$argv[1] : 5000000;
+
+$start = microtime(true);
+$obj = new VmCalls();
+$x = 0;
+for ($i = 0; $i < $n; $i++) {
+	$x = vm_calls_add($x, 1) & 0xffff;
+	$x = VmCalls::twice($x) & 0xffff;
+	$obj->add($x);
+}
+$elapsed = microtime(true) - $start;
+printf("vm_calls: %d iterations: %.3f s\n", $n, $elapsed);
@@ -0,0 +1,21 @@
+<?php
+/* Interpreter dispatch benchmark: tight loops of cheap opcodes.
+ *
+ * Runs $argv[1] (default 20000000) iterations of a loop whose body is a few
+ * arithmetic, comparison and assignment opcodes, so that the time is spent
+ * in dispatching from one handler to the next rather than inside them.
+ */
+$n = isset($argv[1]) ? (int)$argv[1] : 20000000;
+
+$start = microtime(true);
+$sum = 0;
+$i = 0;
+while ($i < $n) {
+	$sum += $i & 7;
+	if ($sum > 1000000) {
+		$sum -= 1000000;
+	}
+	++$i;
+}
+$elapsed = microtime(true) - $start;
+printf("vm_loops: %d iterations: %.3f s\n", $n, $elapsed);
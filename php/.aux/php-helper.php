@@ -322,6 +322,7 @@ $PHP_FAILED_TESTS = array('BORKED' => array(), 'FAILED' => array(), 'WARNED' =>
 
 // If parameters given assume they represent selected tests to run.
 $failed_tests_file= false;
+$result_stream = false;
 $pass_option_n = false;
 $pass_options = '';
 
@@ -510,6 +511,9 @@ if (isset($argc) && $argc > 1) {
                         $repeat = true;
                     }
                     break;
+                case '--result-stream':
+                    $result_stream = fopen($argv[++$i], 'wt');
+                    break;
                 case '--angelix_run':
                     $environment['ANGELIX_RUN'] = $argv[++$i];
                     break;
@@ -542,6 +546,12 @@ Options:
 
     -a <file>   Same as -w but append rather then truncating <file>.
 
+    --result-stream <file>
+                Write one JSON record per test to <file> as soon as the test
+                has finished, holding its name, status, duration in seconds
+                and the peak RSS in kB of its test process (null if the test
+                was skipped or /usr/bin/time is not installed).
+
     -c <file>   Look for php.ini in directory <file> or use <file> as ini.
 
     -n          Pass -n option to the php binary (Do not use a php.ini).
@@ -665,6 +675,10 @@ HELP;
         if ($failed_tests_file) {
             fclose($failed_tests_file);
         }
+
+        if ($result_stream) {
+            fclose($result_stream);
+        }
         /*
         if (count($test_files) || count($test_results)) {
             //compute_summary(); //mkd5m
@@ -934,7 +948,8 @@ function system_with_timeout($commandline, $env = null, $stdin = null)
 
 function run_all_tests($test_files, $env, $redir_tested = null)
 {
-    global $test_results, $failed_tests_file, $php, $test_cnt, $test_idx;
+    global $test_results, $failed_tests_file, $result_stream, $php, $test_cnt, $test_idx;
+    global $test_maxrss;
 
     foreach($test_files as $name) {
         //echo $name . "\n";
@@ -951,8 +966,13 @@ function run_all_tests($test_files, $env, $redir_tested = null)
             $index = $name;
         }
         $test_idx++;
+        $test_start = microtime(true);
+        $test_maxrss = null;
         $result = run_test($php, $name, $env);
 
+        if ($result_stream && !is_array($name) && $result != 'REDIR') {
+            write_result_record($index, $result, microtime(true) - $test_start, $test_maxrss);
+        }
 
         if (!is_array($name) && $result != 'REDIR') {
             $test_results[$index] = $result;
@@ -963,6 +983,32 @@ function run_all_tests($test_files, $env, $redir_tested = null)
     }
 }
 
+//
+//  Write a machine-readable result record
+//
+function write_result_record($name, $result, $duration, $maxrss)
+{
+    global $result_stream;
+
+    $record = sprintf('{"test":%s,"status":"%s","time":%.6f,"maxrss":%s}',
+        json_string($name), $result, $duration,
+        $maxrss === null ? 'null' : (int)$maxrss);
+    fwrite($result_stream, $record . "\n");
+    fflush($result_stream);
+}
+
+//
+//  Quote a string for JSON (ext/json may not be built)
+//
+function json_string($str)
+{
+    $escapes = array('\\' => '\\\\', '"' => '\\"');
+    for ($c = 0; $c < 32; $c++) {
+        $escapes[chr($c)] = sprintf('\\u%04x', $c);
+    }
+    return '"' . strtr($str, $escapes) . '"';
+}
+
 //
 //  Show file or result block
 //
@@ -1007,6 +1053,7 @@ function run_test($php, $file, $env)
     global $leak_check, $temp_source, $temp_target, $cfg, $environment;
     global $no_clean;
     global $valgrind_version;
+    global $result_stream, $test_maxrss;
     $temp_filenames = null;
     $org_file = $file;
 
@@ -1537,7 +1584,20 @@ COMMAND $cmd
     printf("[php-helper] angelix_run: %s\n", $angelix_run);
     $cmd = "$angelix_run $cmd";
     printf("[php-helper] cmd:\n%s\n", $cmd);
+    // Measure the peak RSS of the test process itself for --result-stream;
+    // getrusage() only knows the peak over all children reaped so far.
+    $rss_file = null;
+    if ($result_stream && is_executable('/usr/bin/time')) {
+        $rss_file = tempnam(sys_get_temp_dir(), 'rss');
+        $cmd = '/usr/bin/time -f %M -o ' . escapeshellarg($rss_file) . ' sh -c ' . escapeshellarg($cmd);
+    }
     $out = (binary) system_with_timeout($cmd, $env, isset($section_text['STDIN']) ? $section_text['STDIN'] : null);
+    if ($rss_file) {
+        // time puts a note about a failed exit status before the value.
+        $rss = @file_get_contents($rss_file);
+        $test_maxrss = preg_match('/^(\d+)\s*$/m', (string)$rss, $m) ? (int)$m[1] : null;
+        @unlink($rss_file);
+    }
 
     if (array_key_exists('CLEAN', $section_text) && (!$no_clean || $cfg['keep']['clean'])) {
 
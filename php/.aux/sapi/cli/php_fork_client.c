@@ -0,0 +1,132 @@
+/*
+ * Client for the CLI fork-server mode (see php_fork_server.c).
+ *
+ * Usage: php-fork-client [php options] [file] [args...]
+ *
+ * Sends its stdin/stdout/stderr, working directory, argv and environment to
+ * the server listening on $PHP_FORK_SERVER, waits for the request to finish
+ * and exits with its status.  If no server is reachable it executes
+ * $PHP_FORK_SERVER_FALLBACK (the regular php binary) instead.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+extern char **environ;
+
+static void append(char **buf, size_t *len, size_t *size, const char *s)
+{
+	size_t n = strlen(s) + 1;
+
+	while (*len + n > *size) {
+		*size *= 2;
+		*buf = realloc(*buf, *size);
+		if (!*buf) {
+			perror("php-fork-client");
+			exit(1);
+		}
+	}
+	memcpy(*buf + *len, s, n);
+	*len += n;
+}
+
+static void fallback(char **argv)
+{
+	char *php = getenv("PHP_FORK_SERVER_FALLBACK");
+
+	if (php && *php) {
+		argv[0] = php;
+		execv(php, argv);
+		perror(php);
+	} else {
+		fprintf(stderr, "php-fork-client: no fork server and no PHP_FORK_SERVER_FALLBACK\n");
+	}
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	struct sockaddr_un addr;
+	struct msghdr msg;
+	struct iovec iov;
+	char control[CMSG_SPACE(3 * sizeof(int))];
+	struct cmsghdr *cmsg;
+	char cwd[4096], *buf, *p, **e;
+	size_t len = 2 * sizeof(uint32_t), size = 4096;
+	uint32_t header, *counts, status;
+	int fds[3] = { 0, 1, 2 };
+	int sock, i;
+	char *path = getenv("PHP_FORK_SERVER");
+
+	if (!path || !*path || strlen(path) >= sizeof(addr.sun_path)) {
+		fallback(argv);
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+	sock = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (sock < 0 || connect(sock, (struct sockaddr *) &addr, sizeof(addr)) != 0) {
+		fallback(argv);
+	}
+
+	if (!getcwd(cwd, sizeof(cwd))) {
+		perror("php-fork-client");
+		return 1;
+	}
+
+	buf = malloc(size);
+	append(&buf, &len, &size, cwd);
+	for (i = 0; i < argc; i++) {
+		append(&buf, &len, &size, argv[i]);
+	}
+	for (e = environ, i = 0; *e; e++, i++) {
+		append(&buf, &len, &size, *e);
+	}
+	counts = (uint32_t *) buf;
+	counts[0] = argc;
+	counts[1] = i;
+	header = len;
+
+	memset(&msg, 0, sizeof(msg));
+	iov.iov_base = &header;
+	iov.iov_len = sizeof(header);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+	cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+	memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+	if (sendmsg(sock, &msg, 0) != sizeof(header)) {
+		perror("php-fork-client");
+		return 1;
+	}
+	for (p = buf; len > 0; ) {
+		ssize_t n = write(sock, p, len);
+
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			perror("php-fork-client");
+			return 1;
+		}
+		p += n;
+		len -= n;
+	}
+
+	if (read(sock, &status, sizeof(status)) != sizeof(status)) {
+		return 255;
+	}
+	return status;
+}
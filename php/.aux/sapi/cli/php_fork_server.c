@@ -0,0 +1,309 @@
+/*
+ * Fork-server mode for the CLI SAPI.
+ *
+ * This file is included into sapi/cli/php_cli.c by base/fork-server.sh, and
+ * php_fork_server_wait() is called from main() right before do_cli(), i.e.
+ * after module startup (MINIT, ini parsing, constant registration) and before
+ * request startup.
+ *
+ * When PHP_FORK_SERVER_LISTEN names a socket path, the process does not run
+ * a script itself but listens on that Unix socket.  Clients find the server
+ * through PHP_FORK_SERVER instead, so that a php started with the clients'
+ * environment (e.g. the one running run-tests.php) does not become a second
+ * server.  Every connection from php-fork-client hands over the client's
+ * stdin/stdout/stderr, its working directory, argv and environment; the server forks a supervisor which forks
+ * the worker, and the worker returns from php_fork_server_wait() with the
+ * client's argv so that do_cli() runs the request as usual.  The supervisor
+ * reports the worker's exit status back to the client and kills the worker
+ * if the client goes away (e.g. on a run-tests.php timeout).
+ *
+ * -d options in the client's argv are applied in the worker; -n and -c are
+ * not, so the server must be started with the same ones as the clients.
+ */
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <poll.h>
+#include <signal.h>
+
+#define PHP_FORK_SERVER_MAX_REQUEST (16 * 1024 * 1024)
+
+static int php_fork_server_read(int fd, void *buf, size_t len, int *fds)
+{
+	char *p = buf;
+	int first = 1;
+
+	while (len > 0) {
+		struct msghdr msg;
+		struct iovec iov;
+		char control[CMSG_SPACE(3 * sizeof(int))];
+		ssize_t n;
+
+		memset(&msg, 0, sizeof(msg));
+		iov.iov_base = p;
+		iov.iov_len = len;
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		if (first && fds) {
+			msg.msg_control = control;
+			msg.msg_controllen = sizeof(control);
+		}
+
+		n = recvmsg(fd, &msg, 0);
+		if (n <= 0) {
+			return FAILURE;
+		}
+
+		if (first && fds) {
+			struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+
+			if (!cmsg || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS
+				|| cmsg->cmsg_len != CMSG_LEN(3 * sizeof(int))) {
+				return FAILURE;
+			}
+			memcpy(fds, CMSG_DATA(cmsg), 3 * sizeof(int));
+		}
+		first = 0;
+		p += n;
+		len -= n;
+	}
+	return SUCCESS;
+}
+
+/* Split a block of NUL-terminated strings into a NULL-terminated vector. */
+static char **php_fork_server_strings(char **p, char *end, int count)
+{
+	char **vec = malloc((count + 1) * sizeof(char *));
+	int i;
+
+	for (i = 0; i < count; i++) {
+		char *s = *p;
+
+		while (*p < end && **p) {
+			(*p)++;
+		}
+		if (*p >= end) {
+			free(vec);
+			return NULL;
+		}
+		(*p)++;
+		vec[i] = s;
+	}
+	vec[count] = NULL;
+	return vec;
+}
+
+/* Whether a CLI option is followed by a value in the next argument. */
+static int php_fork_server_takes_value(const char *arg)
+{
+	static const char *const long_opts[] = {
+		"--php-ini", "--file", "--run", "--process-begin", "--process-code",
+		"--process-file", "--process-end", "--zend-extension", "--rfunction",
+		"--rf", "--rclass", "--rc", "--rextension", "--re", "--rzendextension",
+		"--rz", "--rextinfo", "--ri", "--server", "--docroot", NULL
+	};
+	int i;
+
+	if (arg[1] != '-') {
+		return strchr("cfrBRFEzSt", arg[1]) && !arg[2];
+	}
+	for (i = 0; long_opts[i]; i++) {
+		if (!strcmp(arg, long_opts[i])) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* Applies the -d options of the client's argv. Like the CLI's own option
+ * parsing, this stops at the script path or "--", and the values of other
+ * options are skipped, so a -d among the script's arguments is left to the
+ * script; it also stops after -f FILE. Reports to the server's own stderr, as
+ * the worker's request has not taken over the client's yet. */
+static void php_fork_server_apply_ini(int argc, char **argv TSRMLS_DC)
+{
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		char *entry, *name, *value;
+		int name_len;
+
+		if (argv[i][0] != '-' || !argv[i][1] || !strcmp(argv[i], "--")) {
+			break;
+		}
+		if ((!strcmp(argv[i], "-d") || !strcmp(argv[i], "--define")) && i + 1 < argc) {
+			entry = argv[++i];
+		} else if (!strncmp(argv[i], "-d", 2) && argv[i][2]) {
+			entry = argv[i] + 2;
+		} else if (!strncmp(argv[i], "--define=", sizeof("--define=") - 1)) {
+			entry = argv[i] + sizeof("--define=") - 1;
+		} else if (!strncmp(argv[i], "-f", 2) || !strcmp(argv[i], "--file")
+			|| !strncmp(argv[i], "--file=", sizeof("--file=") - 1)) {
+			break;
+		} else {
+			if (php_fork_server_takes_value(argv[i])) {
+				i++;
+			}
+			continue;
+		}
+
+		value = strchr(entry, '=');
+		if (value) {
+			name_len = value - entry;
+			value++;
+		} else {
+			name_len = strlen(entry);
+			value = "1";
+		}
+		name = estrndup(entry, name_len);
+		/* Directives no module knows are ignored, as they are by -d at startup. */
+		if (zend_alter_ini_entry_ex(name, name_len + 1, value, strlen(value),
+				PHP_INI_SYSTEM, PHP_INI_STAGE_STARTUP, 1 TSRMLS_CC) == FAILURE
+			&& zend_hash_exists(EG(ini_directives), name, name_len + 1)) {
+			fprintf(stderr, "php-fork-server: cannot set %s=%s\n", name, value);
+		}
+		efree(name);
+	}
+}
+
+/* Supervise one worker; returns in the worker with its request set up. */
+static void php_fork_server_handle(int conn, int *argc, char ***argv TSRMLS_DC)
+{
+	uint32_t len, counts[2];
+	int fds[3], status;
+	char *buf, *p, *cwd, **env;
+	pid_t pid;
+
+	signal(SIGCHLD, SIG_DFL);
+
+	if (php_fork_server_read(conn, &len, sizeof(len), fds) == FAILURE) {
+		_exit(1);
+	}
+	if (len < sizeof(counts) || len > PHP_FORK_SERVER_MAX_REQUEST
+		|| php_fork_server_read(conn, counts, sizeof(counts), NULL) == FAILURE) {
+		_exit(1);
+	}
+	len -= sizeof(counts);
+	buf = malloc(len + 1);
+	if (!buf || php_fork_server_read(conn, buf, len, NULL) == FAILURE) {
+		_exit(1);
+	}
+	buf[len] = '\0';
+
+	p = buf;
+	cwd = p;
+	p += strlen(cwd) + 1;
+	*argv = php_fork_server_strings(&p, buf + len, counts[0]);
+	env = *argv ? php_fork_server_strings(&p, buf + len, counts[1]) : NULL;
+	if (!env) {
+		_exit(1);
+	}
+	*argc = counts[0];
+
+	pid = fork();
+	if (pid < 0) {
+		_exit(1);
+	}
+
+	if (pid == 0) {
+		char **e;
+
+		close(conn);
+		php_fork_server_apply_ini(counts[0], *argv TSRMLS_CC);
+		dup2(fds[0], STDIN_FILENO);
+		dup2(fds[1], STDOUT_FILENO);
+		dup2(fds[2], STDERR_FILENO);
+		close(fds[0]);
+		close(fds[1]);
+		close(fds[2]);
+
+		clearenv();
+		for (e = env; *e; e++) {
+			putenv(*e);
+		}
+		unsetenv("PHP_FORK_SERVER_LISTEN");
+		if (chdir(cwd) != 0) {
+			_exit(1);
+		}
+		return;
+	}
+
+	close(fds[0]);
+	close(fds[1]);
+	close(fds[2]);
+
+	for (;;) {
+		struct pollfd pfd;
+
+		if (waitpid(pid, &status, WNOHANG) == pid) {
+			break;
+		}
+		/* The client never writes after its request, so any readiness
+		 * means it has hung up. */
+		pfd.fd = conn;
+		pfd.events = POLLIN;
+		if (poll(&pfd, 1, 50) > 0) {
+			kill(pid, SIGKILL);
+			waitpid(pid, &status, 0);
+			break;
+		}
+	}
+
+	if (WIFEXITED(status)) {
+		status = WEXITSTATUS(status);
+	} else {
+		status = 128 + WTERMSIG(status);
+	}
+	len = status;
+	write(conn, &len, sizeof(len));
+	_exit(0);
+}
+
+static void php_fork_server_wait(int *argc, char ***argv TSRMLS_DC)
+{
+	struct sockaddr_un addr;
+	char *path = getenv("PHP_FORK_SERVER_LISTEN");
+	int sock;
+
+	if (!path || !*path) {
+		return;
+	}
+
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		fprintf(stderr, "PHP_FORK_SERVER_LISTEN path is too long: %s\n", path);
+		exit(1);
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+	unlink(path);
+
+	sock = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (sock < 0 || bind(sock, (struct sockaddr *) &addr, sizeof(addr)) != 0
+		|| listen(sock, 128) != 0) {
+		perror("PHP_FORK_SERVER_LISTEN");
+		exit(1);
+	}
+
+	/* Supervisors are never waited for by the server. */
+	signal(SIGCHLD, SIG_IGN);
+
+	for (;;) {
+		int conn = accept(sock, NULL, NULL);
+		pid_t pid;
+
+		if (conn < 0) {
+			continue;
+		}
+
+		pid = fork();
+		if (pid == 0) {
+			close(sock);
+			php_fork_server_handle(conn, argc, argv TSRMLS_CC);
+			return;
+		}
+		close(conn);
+	}
+}
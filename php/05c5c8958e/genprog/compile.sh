@@ -11,6 +11,13 @@
 # of the provided executable should be "sanity" or "coverage", respectively,
 # although neither of these cases should have any impact upon compilation.
 #
+# Only files whose contents differ from the source directory are copied, so
+# that unchanged files keep their timestamps and are not rebuilt. When ccache
+# is available, objects are cached on the hash of each translation unit's
+# preprocessed content, so a candidate that reverts a file to an earlier
+# variant is not recompiled either; the hits and misses of this build are
+# reported after it.
+#
 # Usage: ./compile.sh __EXE_NAME__
 #
 here_dir=$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )
@@ -24,17 +31,61 @@ fi
 exe_name=$1
 candidate_dir=$(dirname $1)
 
-# Copy all the files across from the candidate directory into the source
+# Copy the changed files across from the candidate directory into the source
 # directory for this problem, before re-making the program.
-if !(cp $candidate_dir/* $src_dir -rf); then
+pushd $candidate_dir > /dev/null
+if ! find . -type f -print0 | while IFS= read -r -d '' f; do
+  if ! cmp -s "$f" "$src_dir/$f"; then
+    mkdir -p "$(dirname "$src_dir/$f")"
+    cp -f "$f" "$src_dir/$f" || exit 1
+  fi
+done; then
   echo "ERROR: failed to copy patched files to src directory"
   exit 1
 fi
+popd > /dev/null
+
+use_ccache=""
+if command -v ccache > /dev/null; then
+  use_ccache=1
+  export CCACHE_DIR=${CCACHE_DIR:-$src_dir/../.ccache}
+  export CCACHE_NODIRECT=1
+  # Masquerade as the compiler, so the configured CC is left untouched.
+  mkdir -p $CCACHE_DIR/bin
+  for c in cc gcc; do
+    ln -sf $(command -v ccache) $CCACHE_DIR/bin/$c
+  done
+  export PATH=$CCACHE_DIR/bin:$PATH
+  # An absolute compiler path does not go through PATH, hence not ccache.
+  configured_cc=${CC:-$(sed -n 's/^CC = *//p' $src_dir/Makefile 2> /dev/null | head -n 1)}
+  if [[ $configured_cc == /* ]]; then
+    echo "WARNING: CC is $configured_cc, an absolute path, so ccache is not used"
+  fi
+  # Count hits in a log of this build only; the counters of ccache -s are
+  # shared by every build using the same CCACHE_DIR.
+  export CCACHE_LOGFILE=$(mktemp)
+  trap 'rm -f "$CCACHE_LOGFILE"' EXIT
+fi
 
+# With HOTSWAP=1, after ../hotswap.sh prepare, only the patched translation
+# unit is rebuilt, into the shared object the binary loads; make would relink
+# the binary the regular way and undo prepare. Scenarios without hotswap.sh
+# (all but PHP) always use make.
 # TODO: may need to handle special cases, such as FBC here
 pushd $src_dir
-if !(make > /dev/null); then
+if [[ -n $HOTSWAP && -f $src_dir/../hotswap.sh ]]; then
+  if !(bash $src_dir/../hotswap.sh build > /dev/null); then
+    echo "ERROR: failed to rebuild the hot-swapped object"
+    exit 1
+  fi
+elif !(make > /dev/null); then
   echo "ERROR: failed to execute make within problem src directory"
   exit 1
 fi
-popd
\ No newline at end of file
+popd
+
+if [[ -n $use_ccache ]]; then
+  hits=$(grep -c -E "Result: .*cache[ _]hit" $CCACHE_LOGFILE)
+  misses=$(grep -c -E "Result: cache[ _]miss" $CCACHE_LOGFILE)
+  echo "ccache: $hits hits, $misses misses"
+fi
@@ -42,6 +42,9 @@ cp $dir_name/diffs/${diff_file} $dir_name/src/$(echo $diff_file| cut -d'-' -f 1)
 cd $dir_name/src
 make distclean &> /dev/null
 cp /experiments/benchmark/$benchmark_name/$project_name/base/* $dir_name
+# share unchanged files with the other scenarios of this subject (COW_TREE)
+bash $dir_name/cow-tree.sh $dir_name/../base-src $dir_name/src
+cd $dir_name/src
 # apply libxml fix
 cp -rf $dir_name/src $dir_name/src-bk
 git reset --hard && git clean -fd
@@ -62,7 +65,7 @@ make distclean
 
 
 cd $dir_name
-chmod +x tester.py test.sh
+chmod +x tester.py test.sh runner.py coverage.py
 
 cd $dir_name/src-bk
 find . -name tests.tar.gz -delete && find . -name tests -type d | tar -czf all-tests.tar.gz --files-from -
@@ -42,6 +42,9 @@ cp $dir_name/diffs/${diff_file} $dir_name/src/$(echo $diff_file| cut -d'-' -f 1)
 cd $dir_name/src
 make distclean &> /dev/null
 cp /experiments/benchmark/$benchmark_name/$project_name/base/* $dir_name
+# share unchanged files with the other scenarios of this subject (COW_TREE)
+bash $dir_name/cow-tree.sh $dir_name/../base-src $dir_name/src
+cd $dir_name/src
 # apply libxml fix
 cat ../libxml.patch | patch -p0
 
@@ -57,7 +60,7 @@ sed -i '153i if (0 == 1) break;' ext/tokenizer/tokenizer.c
 
 
 cd $dir_name
-chmod +x tester.py test.sh
+chmod +x tester.py test.sh runner.py coverage.py
 
 ./tester.py build
 
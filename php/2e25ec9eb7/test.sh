@@ -14,17 +14,8 @@ NEG_N=1
 
 if [ -z "$TEST_ID" ]
 then
-   # Run passing test cases
-  for i in `seq -s " " -f "p%g"  1 $POS_N`
-  do
-  bash test.sh $i /data
-  done
-
-  # Run failing test cases
-  for i in `seq -s " " -f "n%g"  1 $NEG_N`
-  do
-  bash test.sh $i /data
-  done
+  # Run passing and failing test cases on a pool of workers
+  ./runner.py $POS_N $NEG_N
 else
    timeout 10 bash test.sh $TEST_ID
 fi
\ No newline at end of file
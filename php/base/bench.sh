@@ -0,0 +1,37 @@
+#!/bin/bash
+# Run the PHP micro-benchmarks in .aux/bench against a scenario's build.
+#
+# Usage: ./bench.sh [NAME...] [-- ARGS...]
+#
+# Runs .aux/bench/NAME.php for every NAME given (all of them by default) with
+# each of the binaries in $BENCH_PHP (default sapi/cli/php, relative to src/);
+# ARGS are passed to every benchmark. Each benchmark prints its own
+# measurement, followed here by its wall time.
+script_dir="$( cd "$( dirname "${BASH_SOURCE[0]}" )" &> /dev/null && pwd )"
+aux=/experiments/benchmark/manybugs/php/.aux
+binaries=(${BENCH_PHP:-sapi/cli/php})
+
+names=()
+while [[ $# -gt 0 && $1 != "--" ]]; do
+  names+=($1)
+  shift
+done
+shift
+if [[ ${#names[@]} -eq 0 ]]; then
+  for f in $aux/bench/*.php; do
+    names+=($(basename $f .php))
+  done
+fi
+
+cd $script_dir/src
+for name in "${names[@]}"; do
+  for php in "${binaries[@]}"; do
+    label=""
+    if [[ ${#binaries[@]} -gt 1 ]]; then
+      label="[$php] "
+      echo -n "$label"
+    fi
+    TIMEFORMAT="$label$name: wall %R s"
+    time $php -n -d memory_limit=-1 $aux/bench/$name.php "$@" || exit 1
+  done
+done
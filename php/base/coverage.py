@@ -0,0 +1,271 @@
+#!/usr/bin/python3
+import difflib
+import glob
+import gzip
+import json
+import multiprocessing
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+import tester
+
+exp_dir = os.path.abspath(os.path.dirname(os.path.realpath(__file__)))
+index_file = exp_dir + "/coverage.idx"
+# The php that runs the tests; run-tests.php itself runs on sapi/cli/php.
+test_php = os.path.join(exp_dir + "/src", tester.test_php)
+
+# Layout of coverage.idx (all integers are unsigned LEB128 varints):
+#   magic "MBCV", version byte
+#   source file path, function count, then per function: name, start line
+#   test count, then per test: identifier, line count, line numbers as deltas
+#   from the previous line, function count, function table indices
+# Strings are stored as a varint length followed by UTF-8 bytes. The source
+# file as it was when the index was built is kept next to it in
+# coverage.idx.src, so that later changes can be mapped to indexed lines.
+MAGIC = b"MBCV"
+VERSION = 1
+
+
+def put_varint(out, n):
+    while True:
+        byte = n & 0x7F
+        n >>= 7
+        if n:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return
+
+
+def get_varint(data, pos):
+    n = shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        n |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return n, pos
+
+
+def put_string(out, s):
+    s = s.encode("utf-8")
+    put_varint(out, len(s))
+    out.extend(s)
+
+
+def get_string(data, pos):
+    n, pos = get_varint(data, pos)
+    return data[pos : pos + n].decode("utf-8"), pos + n
+
+
+def write_index(path, source_file, functions, tests):
+    out = bytearray(MAGIC)
+    out.append(VERSION)
+    put_string(out, source_file)
+    names = sorted(functions, key=lambda f: functions[f])
+    put_varint(out, len(names))
+    for name in names:
+        put_string(out, name)
+        put_varint(out, functions[name])
+    slot = dict((name, i) for i, name in enumerate(names))
+
+    put_varint(out, len(tests))
+    for identifier, (lines, funcs) in sorted(tests.items()):
+        put_string(out, identifier)
+        put_varint(out, len(lines))
+        prev = 0
+        for line in sorted(lines):
+            put_varint(out, line - prev)
+            prev = line
+        put_varint(out, len(funcs))
+        for f in sorted(slot[f] for f in funcs):
+            put_varint(out, f)
+    with open(path, "wb") as f:
+        f.write(out)
+
+
+def read_index(path=index_file):
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:4] != MAGIC or data[4] != VERSION:
+        raise ValueError("not a coverage index: " + path)
+    pos = 5
+    source_file, pos = get_string(data, pos)
+    n, pos = get_varint(data, pos)
+    functions = []
+    for _ in range(n):
+        name, pos = get_string(data, pos)
+        start, pos = get_varint(data, pos)
+        functions.append((name, start))
+
+    tests = {}
+    n, pos = get_varint(data, pos)
+    for _ in range(n):
+        identifier, pos = get_string(data, pos)
+        count, pos = get_varint(data, pos)
+        lines, line = set(), 0
+        for _ in range(count):
+            delta, pos = get_varint(data, pos)
+            line += delta
+            lines.add(line)
+        count, pos = get_varint(data, pos)
+        funcs = set()
+        for _ in range(count):
+            f, pos = get_varint(data, pos)
+            funcs.add(functions[f][0])
+        tests[identifier] = (lines, funcs)
+    return source_file, dict(functions), tests
+
+
+# Parse the output of "gcov -i", either the JSON format of GCC 9 and later or
+# the older intermediate text format.
+def parse_gcov(out_dir, source_file):
+    def same(path):
+        return path.endswith(source_file) or source_file.endswith(path)
+
+    lines, funcs, starts = set(), set(), {}
+    for path in glob.glob(out_dir + "/*.gcov.json.gz"):
+        with gzip.open(path, "rt") as f:
+            report = json.load(f)
+        for entry in report["files"]:
+            if not same(entry["file"]):
+                continue
+            for func in entry["functions"]:
+                starts[func["name"]] = func["start_line"]
+                if func["execution_count"]:
+                    funcs.add(func["name"])
+            for line in entry["lines"]:
+                if line["count"]:
+                    lines.add(line["line_number"])
+    for path in glob.glob(out_dir + "/*.gcov"):
+        current = None
+        with open(path) as f:
+            for l in f:
+                kind, _, value = l.strip().partition(":")
+                if kind == "file":
+                    current = value
+                elif current is None or not same(current):
+                    continue
+                elif kind == "function":
+                    start, count, name = value.split(",", 2)
+                    starts[name] = int(start)
+                    if int(count):
+                        funcs.add(name)
+                elif kind == "lcount":
+                    line, count = value.split(",")[:2]
+                    if int(count):
+                        lines.add(int(line))
+    return lines, funcs, starts
+
+
+def trace_one(args):
+    identifier, source_file = args
+    obj_dir = os.path.dirname(exp_dir + "/src/" + source_file)
+    stem = os.path.splitext(os.path.basename(source_file))[0]
+    with tempfile.TemporaryDirectory() as prefix:
+        driver = prefix + "/driver"
+        # Each test writes its .gcda files below its own GCOV_PREFIX, so the
+        # tests can be traced in parallel. Only the php running the test
+        # gets that prefix, through a wrapper handed to run-tests.php as its
+        # -p; the instrumented php running run-tests.php itself writes its
+        # counts to a prefix that is thrown away.
+        os.mkdir(driver)
+        wrapper = driver + "/php"
+        with open(wrapper, "w") as f:
+            f.write("#!/bin/sh\n")
+            f.write('GCOV_PREFIX={} exec {} "$@"\n'.format(prefix, test_php))
+        os.chmod(wrapper, 0o755)
+        os.environ["GCOV_PREFIX"] = driver
+        os.environ["GCOV_PREFIX_STRIP"] = "0"
+        tester.test_php = wrapper
+        tester.run(identifier, quiet=True)
+        gcda_dir = prefix + obj_dir
+        if not os.path.isfile(gcda_dir + "/" + stem + ".gcda"):
+            return identifier, set(), set(), {}
+        shutil.copy(obj_dir + "/" + stem + ".gcno", gcda_dir)
+        subprocess.run(
+            ["gcov", "-i", "-o", gcda_dir, exp_dir + "/src/" + source_file],
+            cwd=gcda_dir,
+            stdout=subprocess.DEVNULL,
+            stderr=subprocess.DEVNULL,
+        )
+        return (identifier,) + parse_gcov(gcda_dir, source_file)
+
+
+# Run every test against a build compiled with --coverage and index the lines
+# and functions of source_file that each of them executes.
+def build(source_file, ids, jobs=None):
+    tester.load_index()
+    tests, functions = {}, {}
+    with multiprocessing.Pool(jobs or os.cpu_count() or 1) as pool:
+        work = [(identifier, source_file) for identifier in ids]
+        for identifier, lines, funcs, starts in pool.imap_unordered(trace_one, work):
+            tests[identifier] = (lines, funcs)
+            functions.update(starts)
+    write_index(index_file, source_file, functions, tests)
+    shutil.copy(exp_dir + "/src/" + source_file, index_file + ".src")
+
+
+# Lines of the indexed version of the source file that differ from the
+# current one; an insertion counts as a change of the lines around it.
+def changed_lines(source_file):
+    with open(index_file + ".src", errors="ignore") as f:
+        before = f.readlines()
+    with open(exp_dir + "/src/" + source_file, errors="ignore") as f:
+        after = f.readlines()
+    changed = set()
+    matcher = difflib.SequenceMatcher(None, before, after, autojunk=False)
+    for tag, i1, i2, _, _ in matcher.get_opcodes():
+        if tag == "equal":
+            continue
+        if i1 == i2:
+            changed.update(range(max(1, i1), i1 + 2))
+        else:
+            changed.update(range(i1 + 1, i2 + 1))
+    return changed
+
+
+# Order ids so that tests executing a changed line run first, then tests
+# entering a changed function, then the rest. With only=True, the tests that
+# touch neither are dropped, except for the failing (n*) ones.
+def prioritize(ids, only=False):
+    source_file, functions, tests = read_index()
+    changed = changed_lines(source_file)
+    starts = sorted((start, name) for name, start in functions.items())
+    touched = set()
+    for line in changed:
+        enclosing = [name for start, name in starts if start <= line]
+        if enclosing:
+            touched.add(enclosing[-1])
+
+    def rank(identifier):
+        lines, funcs = tests.get(identifier, (set(), set()))
+        if lines & changed:
+            return 0
+        if funcs & touched:
+            return 1
+        return 2
+
+    ranked = sorted(ids, key=rank)
+    if only:
+        ranked = [i for i in ranked if rank(i) < 2 or i[0] == "n"]
+    return ranked
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 4 or sys.argv[1] != "build":
+        print("usage: coverage.py build POS_N NEG_N [SOURCE_FILE]")
+        sys.exit(2)
+    import runner
+
+    pos_n, neg_n = int(sys.argv[2]), int(sys.argv[3])
+    if len(sys.argv) > 4:
+        source_file = sys.argv[4]
+    else:
+        with open(exp_dir + "/manifest.txt") as f:
+            source_file = f.readline().strip()
+    build(source_file, runner.identifiers(pos_n, neg_n))
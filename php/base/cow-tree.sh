@@ -0,0 +1,99 @@
+#!/bin/bash
+# Share the unchanged files of a scenario's source tree with the other
+# scenarios of the same subject, according to $COW_TREE.
+#
+# Usage: ./cow-tree.sh BASE SRC
+#
+# The first scenario to get here seeds BASE with a copy of its SRC. Then:
+#   COW_TREE=overlay  SRC becomes an overlayfs mount with BASE as its lower
+#                     layer; the upper layer (next to SRC, in .cow/) holds
+#                     only the files that differ from BASE, whiteouts for the
+#                     files SRC does not have, and later the build products.
+#                     Needs CAP_SYS_ADMIN; the mount does not survive a
+#                     container restart, run the script again to re-create it.
+#   COW_TREE=reflink  files identical to BASE are replaced by reflink clones,
+#                     which share their blocks until written (btrfs, XFS).
+# Otherwise, or if the file system cannot do either, SRC is left untouched.
+base=$1
+src=$2
+mode=$COW_TREE
+
+if [[ $mode != "overlay" && $mode != "reflink" ]]; then
+  exit 0
+fi
+
+(
+  flock 9
+  if [[ ! -d $base ]]; then
+    cp -a --reflink=auto $src $base.tmp && mv $base.tmp $base
+  fi
+) 9> $base.lock
+
+if [[ $mode == "reflink" ]]; then
+  probe=$(find $base -type f -print -quit)
+  if ! cp --reflink=always $probe $src/.cow-probe 2> /dev/null; then
+    echo "cow-tree: no reflink support, keeping a full copy"
+    exit 0
+  fi
+  rm -f $src/.cow-probe
+  cd $src
+  find . -type f -print0 | while IFS= read -r -d '' f; do
+    if [[ -f $base/$f ]] && cmp -s "$f" "$base/$f"; then
+      cp -a --reflink=always "$base/$f" "$f"
+    fi
+  done
+  exit 0
+fi
+
+layer=$(dirname $src)/.cow
+if mountpoint -q $src; then
+  exit 0
+fi
+# Re-mount an existing scenario, e.g. after a container restart.
+if [[ -d $layer/upper && -z $(ls -A $src) ]]; then
+  mount -t overlay overlay \
+    -o lowerdir=$base,upperdir=$layer/upper,workdir=$layer/work $src
+  exit $?
+fi
+rm -rf $layer
+mkdir -p $layer/upper $layer/work
+
+# Upper layer: directories, files and links that are new or differ.
+cd $src
+find . -mindepth 1 -print0 | while IFS= read -r -d '' f; do
+  if [[ -d $f && ! -L $f ]]; then
+    if [[ ! -d $base/$f || -L $base/$f ]]; then
+      mkdir -p "$layer/upper/$f"
+    fi
+  elif [[ -L $f ]]; then
+    if [[ ! -L $base/$f || $(readlink "$f") != $(readlink "$base/$f") ]]; then
+      mkdir -p "$layer/upper/$(dirname "$f")"
+      cp -a "$f" "$layer/upper/$f"
+    fi
+  elif [[ -L $base/$f || ! -f $base/$f ]] || ! cmp -s "$f" "$base/$f"; then
+    mkdir -p "$layer/upper/$(dirname "$f")"
+    cp -a "$f" "$layer/upper/$f"
+  fi
+done
+
+# Whiteouts for what BASE has and SRC does not.
+cd $base
+find . -mindepth 1 -print0 | while IFS= read -r -d '' f; do
+  if [[ ! -e $src/$f && ! -L $src/$f && -d $src/$(dirname "$f") ]]; then
+    mkdir -p "$layer/upper/$(dirname "$f")"
+    mknod "$layer/upper/$f" c 0 0
+  fi
+done
+
+cd $(dirname $src)
+mv $src $src.full
+mkdir $src
+if mount -t overlay overlay \
+    -o lowerdir=$base,upperdir=$layer/upper,workdir=$layer/work $src; then
+  rm -rf $src.full
+else
+  echo "cow-tree: cannot mount an overlay, keeping a full copy"
+  rmdir $src
+  mv $src.full $src
+  rm -rf $layer
+fi
@@ -0,0 +1,29 @@
+#!/bin/bash
+# Build the CLI fork-server mode into a scenario's sapi/cli/php and the
+# matching sapi/cli/php-fork-client (see .aux/sapi/cli/php_fork_server.c).
+#
+# Usage: ./fork-server.sh
+#
+# Afterwards, start a resident server once per build:
+#   PHP_FORK_SERVER_LISTEN=$PWD/php.sock src/sapi/cli/php &
+# and run the tests through the client (tester.py honours TEST_PHP):
+#   export PHP_FORK_SERVER=$PWD/php.sock
+#   export PHP_FORK_SERVER_FALLBACK=$PWD/src/sapi/cli/php
+#   TEST_PHP=sapi/cli/php-fork-client ./runner.py $POS_N $NEG_N
+script_dir="$( cd "$( dirname "${BASH_SOURCE[0]}" )" &> /dev/null && pwd )"
+aux=/experiments/benchmark/manybugs/php/.aux
+cli_dir=$script_dir/src/sapi/cli
+
+cp $aux/sapi/cli/php_fork_server.c $cli_dir/
+if ! grep -q "php_fork_server_wait" $cli_dir/php_cli.c; then
+  sed -i 's/^int main(int argc, char \*argv\[\])$/#include "php_fork_server.c"\n&/' $cli_dir/php_cli.c
+  sed -i 's/^\(\s*\)exit_status = do_cli(argc, argv TSRMLS_CC);/\1php_fork_server_wait(\&argc, \&argv TSRMLS_CC);\n&/' $cli_dir/php_cli.c
+fi
+if ! grep -q "php_fork_server_wait(&argc" $cli_dir/php_cli.c; then
+  echo "ERROR: could not hook the fork server into sapi/cli/php_cli.c"
+  exit 1
+fi
+
+cd $script_dir/src
+make -j`nproc` || exit 1
+${CC:-cc} -O2 -o $cli_dir/php-fork-client $aux/sapi/cli/php_fork_client.c
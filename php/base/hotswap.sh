@@ -0,0 +1,74 @@
+#!/bin/bash
+# Hot-swap build mode: the scenario's patched translation unit is built into a
+# small shared object that the binary under test links against, so that a
+# candidate patch only needs that one file recompiled.
+#
+# Usage: ./hotswap.sh prepare [SOURCE_FILE] [BINARY]
+#        ./hotswap.sh build
+#        ./hotswap.sh restore
+#
+# prepare  relinks BINARY (default sapi/cli/php) without the object of
+#          SOURCE_FILE (default: first line of manifest.txt) and against
+#          src/.hotswap/libhotswap.so instead. This relies on the binary
+#          being linked with -export-dynamic, as sapi/cli/php is, so that the
+#          shared object can resolve the rest of the program.
+# build    recompiles SOURCE_FILE into libhotswap.so, e.g. after
+#          genprog/compile.sh has copied a candidate over it.
+# restore  relinks BINARY the regular way.
+#
+# Between prepare and restore, the source file must only be rebuilt with
+# build: a regular make sees the newer source, rebuilds the object and
+# relinks BINARY with it, which silently undoes prepare. genprog/compile.sh
+# calls build instead of make when HOTSWAP=1 is set. Run restore before any
+# regular make.
+script_dir="$( cd "$( dirname "${BASH_SOURCE[0]}" )" &> /dev/null && pwd )"
+src_dir=$script_dir/src
+swap_dir=$src_dir/.hotswap
+cmd=$1
+
+cd $src_dir
+
+if [[ $cmd == "prepare" ]]; then
+  source_file=${2:-$(head -n 1 $script_dir/manifest.txt)}
+  binary=${3:-sapi/cli/php}
+  object=${source_file%.c}.lo
+  if [[ ! -f $object ]]; then
+    object=${source_file%.c}.o
+  fi
+  mkdir -p $swap_dir
+  echo $binary > $swap_dir/binary
+
+  # Turn the regular compile command of the translation unit into one that
+  # builds a shared object.
+  compile_cmd=$(make -s -n -B $object | grep -- "-c [^ ]*$source_file" | tail -n 1)
+  if [[ -z $compile_cmd ]]; then
+    echo "ERROR: no compile command found for $source_file"
+    exit 1
+  fi
+  compile_cmd=$(echo "$compile_cmd" | sed -e 's/^.*--mode=compile //' \
+    -e "s# -c \([^ ]*$source_file\) # \1 #" \
+    -e "s# -o [^ ]*\.l\?o\( \|$\)# -o $swap_dir/libhotswap.so\1#")
+  echo "$compile_cmd -fPIC -shared" > $swap_dir/compile.sh
+  bash $swap_dir/compile.sh || exit 1
+
+  # Relink the binary with the object replaced by the shared object.
+  rm -f $binary
+  link_cmd=$(make -s -n $binary | tail -n 1)
+  link_cmd=$(echo "$link_cmd" | sed -e "s# $object # #")
+  echo "$link_cmd $swap_dir/libhotswap.so -Wl,-rpath,$swap_dir" > $swap_dir/link.sh
+  bash $swap_dir/link.sh || exit 1
+
+elif [[ $cmd == "build" ]]; then
+  if [[ ! -f $swap_dir/compile.sh ]]; then
+    echo "ERROR: run ./hotswap.sh prepare first"
+    exit 1
+  fi
+  bash $swap_dir/compile.sh
+
+elif [[ $cmd == "restore" ]]; then
+  rm -f $(cat $swap_dir/binary) && rm -rf $swap_dir && make
+
+else
+  echo "usage: ./hotswap.sh prepare|build|restore"
+  exit 1
+fi
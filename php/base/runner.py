@@ -0,0 +1,214 @@
+#!/usr/bin/python3
+import fcntl
+import json
+import multiprocessing
+import os
+import queue
+import signal
+import sys
+
+import coverage
+import tester
+
+exp_dir = os.path.abspath(os.path.dirname(os.path.realpath(__file__)))
+history_file = exp_dir + "/test-history.json"
+
+# Test directories whose tests share fixture files, temporary names or ports,
+# and therefore always run in a single chunk, one test after the other.
+serial_dirs = [
+    "ext/session/tests",
+    "ext/sockets/tests",
+    "ext/standard/tests/dir",
+    "ext/standard/tests/file",
+    "ext/standard/tests/network",
+]
+
+
+# Build the list of test identifiers for a full validation run, using the
+# same "p<n>" / "n<n>" scheme as tester.py.
+def identifiers(pos_n, neg_n):
+    ids = ["p{}".format(i) for i in range(1, pos_n + 1)]
+    ids += ["n{}".format(i) for i in range(1, neg_n + 1)]
+    return ids
+
+
+# Split the tests into chunks of at most batch tests. A chunk never mixes test
+# directories, and the tests of a directory in serial_dirs form one chunk.
+def make_chunks(ids, batch):
+    dirs = {}
+    for identifier in ids:
+        dirs.setdefault(os.path.dirname(tester.lookup(identifier)), []).append(
+            identifier
+        )
+    chunks = []
+    for directory, dir_ids in dirs.items():
+        if any((directory + "/").startswith(d + "/") for d in serial_dirs):
+            chunks.append(dir_ids)
+        else:
+            chunks += [dir_ids[i : i + batch] for i in range(0, len(dir_ids), batch)]
+    return chunks
+
+
+# SIGTERM handler of the workers, which run_all() terminates when it stops
+# early: kill the tests and helpers still running in their own sessions, and
+# unwind so that run_batch() removes its temporary directory.
+def stop_worker(*_):
+    tester.kill_running()
+    sys.exit(1)
+
+
+# Worker process: runs the chunks it takes from tasks until it gets None, and
+# reports every outcome on outcomes as soon as it is known, followed by
+# (None, None) at the end of each chunk.
+def run_chunks(tasks, outcomes):
+    signal.signal(signal.SIGTERM, stop_worker)
+    # Outcomes nobody reads any more must not block a terminated worker.
+    outcomes.cancel_join_thread()
+    while True:
+        ids = tasks.get()
+        if ids is None:
+            return
+        for identifier, outcome in tester.run_batch(ids):
+            outcomes.put((identifier, outcome))
+        outcomes.put((None, None))
+
+
+# Run the given tests on worker processes, handing them out in batches that
+# each run in one php-helper.php process, and report every outcome as soon
+# as its test is done. With fail_fast, the remaining tests are abandoned as
+# soon as one of them fails. Otherwise every test that got no outcome, e.g.
+# because its worker died, is reported as failed.
+def run_all(ids, jobs=None, batch=None, fail_fast=False):
+    if jobs is None:
+        jobs = int(os.environ.get("TEST_JOBS", os.cpu_count() or 1))
+    jobs = max(1, min(jobs, len(ids)))
+    if batch is None:
+        batch = int(os.environ.get("TEST_BATCH", 0)) or max(
+            1, len(ids) // (jobs * 16)
+        )
+        if fail_fast:
+            batch = min(batch, 8)
+
+    # Load the test lists before forking so every worker shares them.
+    tester.load_index()
+    chunks = make_chunks(ids, batch)
+    tasks, outcomes = multiprocessing.Queue(), multiprocessing.Queue()
+    # Chunks left in the queue when we stop early must not block our exit.
+    tasks.cancel_join_thread()
+    for chunk in chunks + [None] * jobs:
+        tasks.put(chunk)
+    # Plain processes rather than a Pool: Pool.terminate() can deadlock on
+    # a worker that is idle in its task queue, which fail_fast runs into.
+    workers = [
+        multiprocessing.Process(target=run_chunks, args=(tasks, outcomes))
+        for _ in range(jobs)
+    ]
+    for worker in workers:
+        worker.start()
+
+    results = {}
+    finished = 0
+    stopped = False
+    try:
+        while finished < len(chunks):
+            try:
+                identifier, outcome = outcomes.get(timeout=1)
+            except queue.Empty:
+                if not any(worker.is_alive() for worker in workers):
+                    break
+                continue
+            if identifier is None:
+                finished += 1
+                continue
+            results[identifier] = outcome
+            print("{} {}".format(identifier, "PASS" if outcome else "FAIL"))
+            sys.stdout.flush()
+            if fail_fast and not outcome:
+                stopped = True
+                break
+    finally:
+        for worker in workers:
+            if worker.is_alive():
+                worker.terminate()
+        for worker in workers:
+            worker.join()
+    if not stopped:
+        for identifier in ids:
+            if identifier not in results:
+                results[identifier] = False
+                print("{} FAIL".format(identifier))
+        sys.stdout.flush()
+    return results
+
+
+def load_history():
+    try:
+        with open(history_file) as f:
+            return json.load(f)
+    except (OSError, ValueError):
+        return {}
+
+
+# Add one failure to the history of each of the given tests. Concurrent
+# validations of the same scenario serialize on a lock file next to the
+# history, which is itself replaced on every save.
+def record_failures(failed):
+    with open(history_file + ".lock", "w") as lock:
+        fcntl.flock(lock, fcntl.LOCK_EX)
+        history = load_history()
+        for identifier in failed:
+            history[identifier] = history.get(identifier, 0) + 1
+        with open(history_file + ".tmp", "w") as f:
+            json.dump(history, f)
+        os.replace(history_file + ".tmp", history_file)
+
+
+# Validate a candidate with the tests most likely to reject it first: the
+# failing (n*) tests, then the positive tests by how often they have failed
+# before, stopping at the first failure. Prints a JSON verdict as the last
+# line and remembers the failing test for the ordering of later runs.
+def validate(ids, jobs=None):
+    history = load_history()
+    negative = [i for i in ids if i[0] == "n"]
+    positive = [i for i in ids if i[0] != "n"]
+    positive.sort(key=lambda i: -history.get(i, 0))
+
+    results = {}
+    for phase in [negative, positive]:
+        if phase:
+            results.update(run_all(phase, jobs, fail_fast=True))
+        if not all(results.values()):
+            break
+
+    failed = sorted(i for i, outcome in results.items() if not outcome)
+    if failed:
+        record_failures(failed)
+    accept = not failed and len(results) == len(ids)
+
+    verdict = {
+        "verdict": "accept" if accept else "reject",
+        "failed": failed,
+        "executed": len(results),
+        "total": len(ids),
+    }
+    print(json.dumps(verdict))
+    return accept
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 3:
+        print("usage: runner.py POS_N NEG_N [JOBS]")
+        sys.exit(2)
+    pos_n, neg_n = int(sys.argv[1]), int(sys.argv[2])
+    jobs = int(sys.argv[3]) if len(sys.argv) > 3 else None
+    ids = identifiers(pos_n, neg_n)
+    # TEST_IMPACT=order runs the tests covering the changes to the patched
+    # file first, TEST_IMPACT=only runs just those (see coverage.py).
+    impact = os.environ.get("TEST_IMPACT")
+    if impact and os.path.isfile(coverage.index_file):
+        ids = coverage.prioritize(ids, only=impact == "only")
+    # TEST_FAIL_FAST=1 stops at the first failing test (see validate()).
+    if os.environ.get("TEST_FAIL_FAST"):
+        sys.exit(0 if validate(ids, jobs) else 1)
+    results = run_all(ids, jobs)
+    sys.exit(0 if len(results) == len(ids) and all(results.values()) else 1)
@@ -1,4 +1,14 @@
 #!/bin/bash
 #!/bin/bash
 script_dir="$( cd "$( dirname "${BASH_SOURCE[0]}" )" &> /dev/null && pwd )"
-$script_dir/tester.py run $@
\ No newline at end of file
+# Use the resident tester (./tester.py serve) when one is listening. A socket
+# left behind by a killed tester gives no reply; run the test directly then.
+if [[ -S $script_dir/tester.sock ]] && command -v socat &> /dev/null; then
+  outcome=$(echo "run $1" | socat - UNIX-CONNECT:$script_dir/tester.sock 2> /dev/null)
+  if [[ $outcome == "PASS" || $outcome == "FAIL" ]]; then
+    echo $outcome
+    [[ $outcome == "PASS" ]]
+    exit $?
+  fi
+fi
+$script_dir/tester.py run $@
@@ -1,14 +1,23 @@
 #!/usr/bin/python3
 import fnmatch
+import json
 import os
 import shutil
+import signal
+import socketserver
 import sys
 import subprocess
+import tempfile
+import time
 
 from subprocess import Popen, PIPE
 
 DEVNULL = open(os.devnull, "w")
 exp_dir = os.path.abspath(os.path.dirname(os.path.realpath(__file__)))
+test_php = os.environ.get("TEST_PHP", "sapi/cli/php")
+helper = os.environ.get(
+    "PHP_HELPER", "/experiments/benchmark/manybugs/php/.aux/php-helper.php"
+)
 
 fail_list = [
     "ext/reflection/tests/traits005.phpt",
@@ -109,34 +118,63 @@ def preexec():
     os.setsid()
 
 
-def run(identifier, exe=None):
-    global exp_dir
-    if identifier[0] == "p":
-        offset = int(identifier[1:]) - 1
-        with open(exp_dir + "/passing.tests.txt") as f:
-            test = f.readlines()[offset]
-    elif identifier[0] == "n":
-        offset = int(identifier[1:]) - 1
-        with open(exp_dir + "/failing.tests.txt") as f:
-            test = f.readlines()[offset]
-    else:
-        with open(exp_dir + "/tests.all.txt") as f:
-            test = f.readlines()[int(identifier) - 1]
-    test = test.strip()
+# Process groups of the tests and helpers this process is running; they are
+# in sessions of their own, so killing this process does not reach them.
+running = set()
+
+
+def kill_running():
+    for pgid in list(running):
+        try:
+            os.killpg(pgid, signal.SIGKILL)
+        except ProcessLookupError:
+            pass
+
+
+# In-memory copy of the test lists, loaded once per process so that a
+# long-lived tester (see serve()) does not re-read them for every test.
+index = None
+
+
+def load_index():
+    global index
+    if index is None:
+        index = {}
+        for key, name in [
+            ("p", "passing.tests.txt"),
+            ("n", "failing.tests.txt"),
+            ("", "tests.all.txt"),
+        ]:
+            with open(exp_dir + "/" + name) as f:
+                index[key] = [t.strip() for t in f]
+    return index
+
+
+def lookup(identifier):
+    tests = load_index()
+    if identifier[0] in ["p", "n"]:
+        return tests[identifier[0]][int(identifier[1:]) - 1]
+    return tests[""][int(identifier) - 1]
+
+
+def run(identifier, exe=None, quiet=False):
+    test = lookup(identifier)
 
     # determine a time limit (measured in seconds)
     tlim = 60
 
-    print("Running test ({}): {}".format(identifier, test))
+    if not quiet:
+        print("Running test ({}): {}".format(identifier, test))
 
     # TODO: Should we stay true to the original ManyBugs and use the compiled executable,
     #       or should we use another (reducing the likelihood of accepting a
     #       plausible but incorrect patch).
-    cmd = ["sapi/cli/php", "run-tests.php", "-p", "sapi/cli/php", test]
+    cmd = ["sapi/cli/php", "run-tests.php", "-p", test_php, test]
 
     with Popen(
         cmd, stdout=PIPE, stderr=DEVNULL, preexec_fn=preexec, cwd=exp_dir + "/src"
     ) as p:
+        running.add(p.pid)
         try:
             stdout = p.communicate(timeout=tlim)[0]
             try:
@@ -155,13 +193,105 @@ def run(identifier, exe=None):
         except:
             return False
 
+        finally:
+            running.discard(p.pid)
+
     return False
 
 
+# Run a batch of tests through a single php-helper.php process, consuming
+# the records of its --result-stream as each test finishes.
+def run_batch(identifiers):
+    if not os.path.isfile(helper):
+        for identifier in identifiers:
+            yield identifier, run(identifier, quiet=True)
+        return
+
+    pending = dict((lookup(identifier), identifier) for identifier in identifiers)
+    tlim = 60 * len(pending)
+    with tempfile.TemporaryDirectory() as tmp_dir:
+        with open(tmp_dir + "/tests.txt", "w") as f:
+            for t in pending:
+                f.write("{}\n".format(t))
+        open(tmp_dir + "/results", "w").close()
+
+        cmd = ["sapi/cli/php", helper, "-p", test_php]
+        cmd += ["--result-stream", tmp_dir + "/results", "-r", tmp_dir + "/tests.txt"]
+        deadline = time.time() + tlim
+        with Popen(
+            cmd,
+            stdout=DEVNULL,
+            stderr=DEVNULL,
+            preexec_fn=preexec,
+            cwd=exp_dir + "/src",
+        ) as p, open(tmp_dir + "/results") as results:
+            running.add(p.pid)
+            try:
+                while pending:
+                    line = results.readline()
+                    if not line:
+                        if p.poll() is not None:
+                            break
+                        if time.time() > deadline:
+                            os.killpg(p.pid, signal.SIGKILL)
+                            break
+                        time.sleep(0.05)
+                        continue
+                    try:
+                        record = json.loads(line)
+                    except ValueError:
+                        continue
+                    test = record["test"]
+                    if os.path.isabs(test):
+                        test = os.path.relpath(test, exp_dir + "/src")
+                    if test in pending:
+                        passed = record["status"] in ["PASSED", "SKIPPED"]
+                        yield pending.pop(test), passed
+            finally:
+                running.discard(p.pid)
+
+    # Tests without a record crashed or timed out the helper.
+    for identifier in pending.values():
+        yield identifier, False
+
+
+class RequestHandler(socketserver.StreamRequestHandler):
+    def handle(self):
+        for line in self.rfile:
+            cmd, _, identifier = line.decode("ascii").strip().partition(" ")
+            if cmd != "run" or not identifier:
+                reply = "ERROR"
+            else:
+                try:
+                    reply = "PASS" if run(identifier, quiet=True) else "FAIL"
+                except (IndexError, ValueError):
+                    reply = "ERROR"
+            self.wfile.write("{}\n".format(reply).encode("ascii"))
+            self.wfile.flush()
+
+
+# Answer "run <identifier>" requests on a local Unix socket, one result line
+# per request, without paying interpreter startup or list parsing per test.
+def serve(sock_path=None):
+    if sock_path is None:
+        sock_path = exp_dir + "/tester.sock"
+    if os.path.exists(sock_path):
+        os.unlink(sock_path)
+    load_index()
+    signal.signal(signal.SIGTERM, lambda *_: sys.exit(0))
+    with socketserver.ThreadingUnixStreamServer(sock_path, RequestHandler) as server:
+        try:
+            server.serve_forever()
+        finally:
+            os.unlink(sock_path)
+
+
 if __name__ == "__main__":
     cmd = sys.argv[1]
     if cmd == "build":
         build()
+    elif cmd == "serve":
+        serve(*sys.argv[2:])
     elif cmd == "run":
         if run(*sys.argv[2:]):
             print("PASS")
@@ -0,0 +1,194 @@
+#!/bin/bash
+# Apply opt-in engine changes from .aux to a scenario's source tree and
+# rebuild it. They are not part of any scenario by default, as they change
+# engine files that some scenarios repair; run this after transform.sh, and
+# again whenever a candidate has been copied over the file it touches.
+#
+# Usage: ./tune-engine.sh cv-index|const-fold|dead-code
+#        ./tune-engine.sh method-cache
+#        ./tune-engine.sh call-site-cache [CALL|SWITCH|GOTO]
+#        ./tune-engine.sh fast-zpp [FILE...]
+#        ./tune-engine.sh vm-kind CALL|SWITCH|GOTO
+#
+# cv-index  replaces lookup_cv() in Zend/zend_compile.c with the version in
+#           .aux/Zend/zend_compile_lookup_cv.c, which looks compiled variables
+#           up through a hash index in large functions and grows the vars
+#           array geometrically. Measure it with bench.sh compile_cvs.
+# const-fold  wraps zend_do_binary_op() and zend_do_unary_op() in
+#           Zend/zend_compile.c with .aux/Zend/zend_compile_const_fold.c,
+#           which folds operators on scalar literals into a literal instead
+#           of emitting an opcode. Measure it with bench.sh const_exprs.
+# dead-code  makes pass_two() in Zend/zend_opcode.c first drop the opcodes
+#           that no path reaches, using .aux/Zend/zend_opcode_dead_code.c.
+#           Dropped code was never run, so this only shrinks op_arrays; it
+#           mostly finds code after return/throw and branches that
+#           const-fold turned into constant conditions.
+# method-cache  makes zend_std_get_method() and zend_std_get_static_method()
+#           in Zend/zend_object_handlers.c take the lowercased name and hash
+#           of a dynamic method name from the cache in
+#           .aux/Zend/zend_object_handlers_method_cache.c. Measure it with
+#           bench.sh dynamic_calls.
+# call-site-cache  installs .aux/Zend/zend_call_site_cache.h, gives every
+#           $obj->$name() call its own run-time cache slots in
+#           zend_do_begin_method_call() and makes ZEND_INIT_METHOD_CALL in
+#           Zend/zend_vm_def.h look such calls up through them, so repeated
+#           (class, name) pairs skip get_method(). Zend/zend_vm_execute.h is
+#           then regenerated as for vm-kind, with the given kind (default
+#           CALL). Measure it with bench.sh dynamic_calls.
+# fast-zpp  installs .aux/Zend/zend_fast_zpp.h and puts its exact-type fast
+#           path in front of every zend_parse_parameters() call with a plain
+#           l/s/b/z/a spec in FILE (default Zend/zend_builtin_functions.c,
+#           which holds strlen(), strcmp() and friends). Measure it with
+#           bench.sh builtin_calls.
+# vm-kind   regenerates Zend/zend_vm_execute.h with the given dispatch kind:
+#           CALL (the default, one function per handler), SWITCH, or GOTO
+#           (handlers are labels in execute() and dispatch is a computed
+#           goto). The generator is run by $PHP, or by the scenario's own
+#           sapi/cli/php, which therefore has to be built first. The result
+#           is also kept as sapi/cli/php-vm-KIND, so that the kinds can be
+#           compared with BENCH_PHP="sapi/cli/php-vm-CALL sapi/cli/php-vm-GOTO"
+#           bench.sh vm_loops vm_calls vm_arrays.
+script_dir="$( cd "$( dirname "${BASH_SOURCE[0]}" )" &> /dev/null && pwd )"
+aux=/experiments/benchmark/manybugs/php/.aux
+cmd=$1
+
+cd $script_dir/src
+
+if [[ $cmd == "cv-index" ]]; then
+  if ! grep -q "ZEND_CV_INDEX_MIN" Zend/zend_compile.c; then
+    awk -v repl=$aux/Zend/zend_compile_lookup_cv.c '
+      /^static int lookup_cv\(/ { skip = 1; while ((getline l < repl) > 0) print l }
+      !skip { print }
+      skip && /^\/\* }}} \*\/$/ { skip = 0 }
+    ' Zend/zend_compile.c > Zend/zend_compile.c.tmp
+    mv Zend/zend_compile.c.tmp Zend/zend_compile.c
+  fi
+  if ! grep -q "ZEND_CV_INDEX_MIN" Zend/zend_compile.c; then
+    echo "ERROR: could not replace lookup_cv in Zend/zend_compile.c"
+    exit 1
+  fi
+
+elif [[ $cmd == "const-fold" ]]; then
+  if ! grep -q "zend_fold_binary_op" Zend/zend_compile.c; then
+    awk -v repl=$aux/Zend/zend_compile_const_fold.c '
+      { sub(/^void zend_do_binary_op\(/, "static void zend_emit_binary_op(") }
+      sub(/^void zend_do_unary_op\(/, "static void zend_emit_unary_op(") { hook = 1 }
+      { print }
+      hook && /^\/\* }}} \*\/$/ { print ""; while ((getline l < repl) > 0) print l; hook = 0 }
+    ' Zend/zend_compile.c > Zend/zend_compile.c.tmp
+    mv Zend/zend_compile.c.tmp Zend/zend_compile.c
+  fi
+  if [[ $(grep -c "^static void zend_emit_\(binary\|unary\)_op(" Zend/zend_compile.c) != 2 ]]; then
+    echo "ERROR: could not hook constant folding into Zend/zend_compile.c"
+    exit 1
+  fi
+
+elif [[ $cmd == "dead-code" ]]; then
+  if ! grep -q "zend_remove_unreachable_ops" Zend/zend_opcode.c; then
+    perl -0pi -e '
+      BEGIN { local $/; open(F, "<", shift @ARGV) or die; $helper = <F>; close(F) }
+      s/^(ZEND_API int pass_two\(zend_op_array \*op_array TSRMLS_DC\)\n\{.*?\n\t\treturn 0;\n\t\}\n)/$helper$1\tzend_remove_unreachable_ops(op_array);\n/ms;
+    ' $aux/Zend/zend_opcode_dead_code.c Zend/zend_opcode.c
+  fi
+  if [[ $(grep -c "zend_remove_unreachable_ops(op_array);" Zend/zend_opcode.c) != 1 ]]; then
+    echo "ERROR: could not hook dead code removal into Zend/zend_opcode.c"
+    exit 1
+  fi
+
+elif [[ $cmd == "method-cache" ]]; then
+  if ! grep -q "zend_dynamic_method_key" Zend/zend_object_handlers.c; then
+    perl -0pi -e '
+      BEGIN { local $/; open(F, "<", shift @ARGV) or die; $helper = <F>; close(F) }
+      s/^(static union _zend_function \*\s*zend_std_get_method\()/$helper$1/m;
+      s/zend_str_tolower_copy\((\w+),\s*(\w+),\s*(\w+)\);\s*hash_value = zend_hash_func\(\1,\s*\3 \+ 1\);/hash_value = zend_dynamic_method_key(\1, \2, \3);/g;
+    ' $aux/Zend/zend_object_handlers_method_cache.c Zend/zend_object_handlers.c
+  fi
+  if [[ $(grep -c "= zend_dynamic_method_key(" Zend/zend_object_handlers.c) != 2 ]]; then
+    echo "ERROR: could not hook the method key cache into Zend/zend_object_handlers.c"
+    exit 1
+  fi
+
+elif [[ $cmd == "call-site-cache" ]]; then
+  kind=${2:-CALL}
+  php=${PHP:-$script_dir/src/sapi/cli/php}
+  if [[ ! -x $php ]]; then
+    echo "ERROR: no PHP binary to run Zend/zend_vm_gen.php, build first or set PHP"
+    exit 1
+  fi
+  cp $aux/Zend/zend_call_site_cache.h Zend/
+  if ! grep -q "zend_call_site_cache.h" Zend/zend_compile.c; then
+    perl -0pi -e '
+      s/^([ \t]*)(last_op->opcode = ZEND_INIT_METHOD_CALL;\n)/$1$2$1if (last_op->op2_type != IS_CONST) {\n$1\tlast_op->extended_value = CG(active_op_array)->last_cache_slot;\n$1\tCG(active_op_array)->last_cache_slot += ZEND_CALL_SITE_CACHE_SLOTS;\n$1}\n/m
+        and s{^(#include "zend_API.h"\n)}{$1#include "zend_call_site_cache.h"\n}m;
+    ' Zend/zend_compile.c
+  fi
+  if ! grep -q "zend_call_site_cache.h" Zend/zend_execute.c; then
+    perl -0pi -e 's{^(#include "zend_API.h"\n)}{$1#include "zend_call_site_cache.h"\n}m' Zend/zend_execute.c
+  fi
+  if ! grep -q "zend_call_site_get_method" Zend/zend_vm_def.h; then
+    perl -0pi -e '
+      s/Z_OBJ_HT_P\(EX\(object\)\)->get_method\(&EX\(object\), function_name_strval, function_name_strlen, \(\(OP2_TYPE == IS_CONST\) \? \(opline->op2\.literal \+ 1\) : NULL\) TSRMLS_CC\)/((OP2_TYPE == IS_CONST)\n\t\t\t\t? Z_OBJ_HT_P(EX(object))->get_method(&EX(object), function_name_strval, function_name_strlen, opline->op2.literal + 1 TSRMLS_CC)\n\t\t\t\t: zend_call_site_get_method(&EX(object), function_name_strval, function_name_strlen, &CACHED_PTR(opline->extended_value) TSRMLS_CC))/
+    ' Zend/zend_vm_def.h
+  fi
+  if ! grep -q "ZEND_CALL_SITE_CACHE_SLOTS;" Zend/zend_compile.c ||
+     ! grep -q "zend_call_site_cache.h" Zend/zend_execute.c ||
+     ! grep -q "zend_call_site_get_method" Zend/zend_vm_def.h; then
+    echo "ERROR: could not hook the call site cache into the engine"
+    exit 1
+  fi
+  (cd Zend && $php -n zend_vm_gen.php --with-vm-kind=$kind) || exit 1
+
+elif [[ $cmd == "fast-zpp" ]]; then
+  shift
+  files=${@:-Zend/zend_builtin_functions.c}
+  cp $aux/Zend/zend_fast_zpp.h Zend/
+  for file in $files; do
+    if grep -q "zend_fast_zpp.h" $file; then
+      continue
+    fi
+    perl -0pi -e '
+      sub fast {
+        my ($spec, $args, $call) = @_;
+        my @dest = grep { $_ ne "" } split /,\s*&/, $args;
+        my @checks;
+        for my $c (split //, $spec) {
+          my $n = scalar @checks;
+          if ($c eq "s") {
+            return $call if @dest < 2;
+            push @checks, "ZEND_FAST_ARG_S($n, " . shift(@dest) . ", " . shift(@dest) . ")";
+          } else {
+            return $call if !@dest;
+            push @checks, "ZEND_FAST_ARG_" . uc($c) . "($n, " . shift(@dest) . ")";
+          }
+        }
+        return $call if @dest;
+        return "(!(ZEND_NUM_ARGS() == " . scalar(@checks) . " && " . join(" && ", @checks) . ")\n\t\t&& $call)";
+      }
+      s{zend_parse_parameters\(ZEND_NUM_ARGS\(\) TSRMLS_CC, "([lsbza]+)"((?:,\s*&\w+)+)\) == FAILURE}{fast($1, $2, $&)}ge
+        and s{^(#include "zend_API.h"\n)}{$1#include "zend_fast_zpp.h"\n}m;
+    ' $file
+    echo "fast-zpp: $file: $(grep -c "ZEND_FAST_ARG_" $file) call sites"
+  done
+
+elif [[ $cmd == "vm-kind" ]]; then
+  kind=$2
+  if [[ $kind != "CALL" && $kind != "SWITCH" && $kind != "GOTO" ]]; then
+    echo "usage: ./tune-engine.sh vm-kind CALL|SWITCH|GOTO"
+    exit 1
+  fi
+  php=${PHP:-$script_dir/src/sapi/cli/php}
+  if [[ ! -x $php ]]; then
+    echo "ERROR: no PHP binary to run Zend/zend_vm_gen.php, build first or set PHP"
+    exit 1
+  fi
+  (cd Zend && $php -n zend_vm_gen.php --with-vm-kind=$kind) || exit 1
+  make -j`nproc` || exit 1
+  cp sapi/cli/php sapi/cli/php-vm-$kind
+  exit 0
+
+else
+  echo "usage: ./tune-engine.sh cv-index|const-fold|dead-code|method-cache|call-site-cache|fast-zpp|vm-kind KIND"
+  exit 1
+fi
+
+make -j`nproc`
@@ -0,0 +1,298 @@
+#!/usr/bin/python3
+# Run the setup, config, build and test scripts of every scenario listed in
+# meta-data.json as one job graph on a work-stealing pool of workers.
+#
+# Each scenario contributes a chain setup -> config -> build -> test shards,
+# where every test shard runs a slice of its p*/n* test identifiers through
+# the scenario's test.sh, each with the scenario's test_timeout. A shard
+# reports how many tests passed, failed and timed out, and fails if a p* test
+# did not pass or an n* test did not fail. Jobs declare a CPU and memory
+# budget, and a worker only starts a job when it fits into what is left of
+# the machine-wide budget. The CPU budget is also handed to the job through
+# OMP_NUM_THREADS, which `nproc` (and therefore `make -j$(nproc)` in
+# build.sh) honours. The memory budget only gates admission, unless
+# --enforce-memory also caps every process of a job at it (RLIMIT_AS).
+#
+# Usage: ./scheduler.py [--root /experiment] [--subjects php,gzip] ...
+#        (see --help)
+import argparse
+import collections
+import json
+import os
+import random
+import resource
+import signal
+import subprocess
+import sys
+import threading
+import time
+
+benchmark_dir = os.path.abspath(os.path.dirname(os.path.realpath(__file__)))
+STAGES = ["setup", "config", "build", "test"]
+
+
+class Job:
+    def __init__(self, name, cmd, cwd, cpus, memory):
+        self.name = name
+        self.cmd = cmd
+        self.cwd = cwd
+        self.cpus = cpus
+        self.memory = memory
+        self.deps = 0
+        self.dependents = []
+        self.status = None
+        self.seconds = 0.0
+        # Test shards: identifiers appended to cmd one at a time, the time
+        # limit of each run, and the outcome counts.
+        self.tests = []
+        self.timeout = None
+        self.counts = None
+
+    def then(self, job):
+        self.dependents.append(job)
+        job.deps += 1
+        return job
+
+
+def scenario_jobs(entry, args):
+    subject, bug_id = entry["subject"], str(entry["bug_id"])
+    script_dir = os.path.join(benchmark_dir, subject, bug_id)
+    if not os.path.isdir(script_dir):
+        return []
+
+    name = "{}/{}".format(subject, bug_id)
+    jobs, prev = [], None
+    for stage in STAGES:
+        if stage not in args.stages or stage == "test":
+            continue
+        job = Job(
+            "{}:{}".format(name, stage),
+            ["bash", os.path.join(script_dir, stage + ".sh"), args.root],
+            script_dir,
+            args.build_cpus,
+            args.build_memory,
+        )
+        if prev is not None:
+            prev.then(job)
+        jobs.append(job)
+        prev = job
+
+    if "test" in args.stages:
+        ids = ["p{}".format(i) for i in range(1, entry["count_pos"] + 1)]
+        ids += ["n{}".format(i) for i in range(1, entry["count_neg"] + 1)]
+        for start in range(0, len(ids), args.shard_size):
+            job = Job(
+                "{}:test[{}]".format(name, start // args.shard_size),
+                ["bash", os.path.join(script_dir, "test.sh"), args.root],
+                script_dir,
+                1,
+                args.test_memory,
+            )
+            job.tests = ids[start : start + args.shard_size]
+            job.timeout = entry.get("test_timeout")
+            if prev is not None:
+                prev.then(job)
+            jobs.append(job)
+    return jobs
+
+
+class Scheduler:
+    def __init__(self, jobs, workers, cpus, memory, log_dir, enforce_memory=False):
+        self.jobs = jobs
+        self.enforce_memory = enforce_memory
+        self.cpus = cpus
+        self.memory = memory
+        self.total_cpus, self.total_memory = cpus, memory
+        self.log_dir = log_dir
+        self.lock = threading.Condition()
+        self.queues = [collections.deque() for _ in range(workers)]
+        self.pending = len(jobs)
+        ready = [job for job in jobs if job.deps == 0]
+        for i, job in enumerate(ready):
+            self.queues[i % workers].append(job)
+
+    def fits(self, job):
+        if job.cpus <= self.cpus and job.memory <= self.memory:
+            return True
+        # A job larger than the whole budget may still run on an idle machine.
+        return self.cpus == self.total_cpus and self.memory == self.total_memory
+
+    # Take a job from the bottom of our own deque, or steal one from the top
+    # of another worker's deque, skipping jobs that do not fit the budget.
+    def take(self, me):
+        own = self.queues[me]
+        for job in reversed(own):
+            if self.fits(job):
+                own.remove(job)
+                return job
+        victims = [q for i, q in enumerate(self.queues) if i != me and q]
+        random.shuffle(victims)
+        for victim in victims:
+            for job in victim:
+                if self.fits(job):
+                    victim.remove(job)
+                    return job
+        return None
+
+    def skip(self, job):
+        job.status = "skipped"
+        self.pending -= 1
+        report(job)
+        for dep in job.dependents:
+            self.skip(dep)
+
+    def worker(self, me):
+        while True:
+            with self.lock:
+                job = None
+                while self.pending > 0:
+                    job = self.take(me)
+                    if job is not None:
+                        break
+                    self.lock.wait()
+                if job is None:
+                    return
+                self.cpus -= job.cpus
+                self.memory -= job.memory
+
+            job.status = self.run(job)
+
+            with self.lock:
+                self.cpus += job.cpus
+                self.memory += job.memory
+                self.pending -= 1
+                report(job)
+                for dep in job.dependents:
+                    if job.status != "ok":
+                        self.skip(dep)
+                        continue
+                    dep.deps -= 1
+                    if dep.deps == 0:
+                        self.queues[me].append(dep)
+                self.lock.notify_all()
+
+    def run(self, job):
+        env = dict(os.environ)
+        env["OMP_NUM_THREADS"] = str(job.cpus)
+        log = os.path.join(self.log_dir, job.name.replace("/", "-") + ".log")
+        start = time.time()
+        with open(log, "w") as out:
+            if job.tests:
+                status = self.run_tests(job, env, out)
+            else:
+                ret = self.call(job, job.cmd, env, out, None)
+                status = "ok" if ret == 0 else "failed"
+        job.seconds = time.time() - start
+        return status
+
+    # Run one test after the other; a p* test is expected to pass and an n*
+    # test to fail on the unrepaired program.
+    def run_tests(self, job, env, out):
+        job.counts = {"passed": 0, "failed": 0, "timeout": 0, "unexpected": 0}
+        for identifier in job.tests:
+            out.write("--- {}\n".format(identifier))
+            out.flush()
+            ret = self.call(job, job.cmd + [identifier], env, out, job.timeout)
+            if ret is None:
+                job.counts["timeout"] += 1
+            else:
+                job.counts["passed" if ret == 0 else "failed"] += 1
+            if (ret == 0) != (identifier[0] == "p"):
+                job.counts["unexpected"] += 1
+        return "ok" if job.counts["unexpected"] == 0 else "failed"
+
+    # Run cmd in its own process group, killed as a whole on timeout; returns
+    # the exit status, or None on timeout.
+    def call(self, job, cmd, env, out, timeout):
+        def limit():
+            if self.enforce_memory:
+                size = job.memory * 1024 * 1024
+                resource.setrlimit(resource.RLIMIT_AS, (size, size))
+
+        p = subprocess.Popen(
+            cmd,
+            cwd=job.cwd,
+            env=env,
+            stdout=out,
+            stderr=subprocess.STDOUT,
+            start_new_session=True,
+            preexec_fn=limit,
+        )
+        try:
+            return p.wait(timeout=timeout)
+        except subprocess.TimeoutExpired:
+            os.killpg(p.pid, signal.SIGKILL)
+            p.wait()
+            return None
+
+    def run_all(self):
+        threads = [
+            threading.Thread(target=self.worker, args=(i,))
+            for i in range(len(self.queues))
+        ]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+
+
+def report(job):
+    record = {"job": job.name, "status": job.status, "seconds": round(job.seconds, 3)}
+    if job.counts is not None:
+        record.update(job.counts)
+    print(json.dumps(record))
+    sys.stdout.flush()
+
+
+def total_memory_mb():
+    try:
+        with open("/proc/meminfo") as f:
+            for line in f:
+                if line.startswith("MemTotal:"):
+                    return int(line.split()[1]) // 1024
+    except OSError:
+        pass
+    return 1 << 20
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(
+        description="Run the ManyBugs scenarios from meta-data.json as one job graph."
+    )
+    parser.add_argument("--root", default="/experiment")
+    parser.add_argument("--subjects", help="comma-separated subjects to run")
+    parser.add_argument("--bugs", help="comma-separated bug ids to run")
+    parser.add_argument("--stages", default=",".join(STAGES))
+    parser.add_argument("--workers", type=int, default=os.cpu_count())
+    parser.add_argument("--cpus", type=int, default=os.cpu_count())
+    parser.add_argument("--memory", type=int, default=total_memory_mb(), help="MB")
+    parser.add_argument("--build-cpus", type=int, default=4)
+    parser.add_argument("--build-memory", type=int, default=2048, help="MB")
+    parser.add_argument("--test-memory", type=int, default=512, help="MB")
+    parser.add_argument(
+        "--enforce-memory",
+        action="store_true",
+        help="cap every process of a job at its memory budget (RLIMIT_AS)",
+    )
+    parser.add_argument("--shard-size", type=int, default=250)
+    parser.add_argument("--log-dir", default="scheduler-logs")
+    args = parser.parse_args()
+    args.stages = args.stages.split(",")
+
+    with open(os.path.join(benchmark_dir, "meta-data.json")) as f:
+        entries = json.load(f)
+    if args.subjects:
+        entries = [e for e in entries if e["subject"] in args.subjects.split(",")]
+    if args.bugs:
+        entries = [e for e in entries if str(e["bug_id"]) in args.bugs.split(",")]
+
+    jobs = []
+    for entry in entries:
+        jobs += scenario_jobs(entry, args)
+    os.makedirs(args.log_dir, exist_ok=True)
+
+    scheduler = Scheduler(
+        jobs, args.workers, args.cpus, args.memory, args.log_dir, args.enforce_memory
+    )
+    scheduler.run_all()
+    sys.exit(0 if all(job.status == "ok" for job in jobs) else 1)